@@ -2,8 +2,11 @@
 
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
 #include <cinttypes>
@@ -29,6 +32,11 @@ AP_LoggerFileReader::~AP_LoggerFileReader()
     const uint64_t delta = micros - start_micros;
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
     ::printf("Replay rates: %" PRIu64 " bytes/second  %" PRIu64 " messages/second\n", bytes_read*1000000/delta, message_count*1000000/delta);
+    if (mapped != nullptr) {
+        munmap(mapped, mapped_size);
+    }
+    free(state_index.entries);
+    free(time_index.entries);
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
@@ -37,6 +45,19 @@ bool AP_LoggerFileReader::open_log(const char *logfile)
     if (fd == -1) {
         return false;
     }
+
+    // map regular files so messages can be handed out in place. The
+    // mapping is read only, so pages are shared with the page cache
+    // and with other replays of the same log
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            mapped = (uint8_t *)p;
+            mapped_size = st.st_size;
+        }
+    }
     return true;
 }
 
@@ -61,51 +82,210 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
     memcpy(dest, packet_counts, sizeof(packet_counts));
 }
 
-bool AP_LoggerFileReader::update(char type[5])
+/*
+  return the next complete message, or nullptr at the end of the log
+ */
+uint8_t *AP_LoggerFileReader::next_message(void)
 {
-    uint8_t hdr[3];
-    if (read_input(hdr, 3) != 3) {
-        return false;
+    uint8_t *msg;
+    if (mapped != nullptr) {
+        if (offset + 3 > mapped_size) {
+            return nullptr;
+        }
+        msg = &mapped[offset];
+    } else {
+        msg = stream_buf;
+        if (read_input(msg, 3) != 3) {
+            return nullptr;
+        }
     }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
         printf("bad log header\n");
-        return false;
+        return nullptr;
     }
 
-    packet_counts[hdr[2]]++;
+    uint8_t length;
+    if (msg[2] == LOG_FORMAT_MSG) {
+        length = sizeof(struct log_Format);
+    } else {
+        length = formats[msg[2]].length;
+        if (length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", msg[2]);
+            exit(1);
+        }
+    }
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
-        struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
-            return false;
+    if (mapped != nullptr) {
+        if (offset + length > mapped_size) {
+            return nullptr;
         }
+        offset += length;
+        bytes_read += length;
+    } else if (read_input(&msg[3], length-3) != length-3) {
+        return nullptr;
+    }
+    return msg;
+}
+
+bool AP_LoggerFileReader::dispatch_message(uint8_t *msg, char type[5])
+{
+    packet_counts[msg[2]]++;
+    message_count++;
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        memcpy(&f, msg, sizeof(f));
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
         strncpy(type, "FMT", 3);
         type[3] = 0;
 
-        message_count++;
         return handle_log_format_msg(f);
     }
 
-    const struct log_Format &f = formats[hdr[2]];
-    if (f.length == 0) {
-        // can't just throw these away as the format specifies the
-        // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
-        exit(1);
+    const struct log_Format &f = formats[msg[2]];
+    strncpy(type, f.name, 4);
+    type[4] = 0;
+
+    return handle_msg(f,msg);
+}
+
+bool AP_LoggerFileReader::update(char type[5])
+{
+    uint8_t *msg = next_message();
+    if (msg == nullptr) {
+        return false;
     }
+    return dispatch_message(msg, type);
+}
 
-    uint8_t msg[f.length];
+bool AP_LoggerFileReader::offset_list::append(uint64_t ofs, uint64_t time_us)
+{
+    if (count == space) {
+        const uint32_t new_space = space ? space * 2 : 256;
+        struct entry *new_entries = (struct entry *)realloc(entries, new_space * sizeof(struct entry));
+        if (new_entries == nullptr) {
+            return false;
+        }
+        entries = new_entries;
+        space = new_space;
+    }
+    entries[count].offset = ofs;
+    entries[count].time_us = time_us;
+    count++;
+    return true;
+}
+
+/*
+  walk the message headers of the whole log without handling any
+  messages, recording where the FMT and PARM messages are and where
+  each second of the log starts
+ */
+bool AP_LoggerFileReader::build_index(void)
+{
+    uint8_t lengths[256] {};
+    bool timestamped[256] {};
+    int16_t parm_type = -1;
+    uint64_t last_index_us = 0;
+
+    uint64_t ofs = 0;
+    while (ofs + 3 <= mapped_size) {
+        const uint8_t *msg = &mapped[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            break;
+        }
+        const uint8_t msg_type = msg[2];
+        uint8_t length;
+        if (msg_type == LOG_FORMAT_MSG) {
+            length = sizeof(struct log_Format);
+            if (ofs + length > mapped_size) {
+                break;
+            }
+            struct log_Format f;
+            memcpy(&f, msg, sizeof(f));
+            lengths[f.type] = f.length;
+            timestamped[f.type] = (f.format[0] == 'Q' &&
+                                   strncmp(f.labels, "TimeUS,", 7) == 0);
+            if (strncmp(f.name, "PARM", 4) == 0) {
+                parm_type = f.type;
+            }
+            if (!state_index.append(ofs, 0)) {
+                return false;
+            }
+        } else {
+            length = lengths[msg_type];
+            if (length == 0 || ofs + length > mapped_size) {
+                break;
+            }
+            if (msg_type == parm_type) {
+                if (!state_index.append(ofs, 0)) {
+                    return false;
+                }
+            } else if (timestamped[msg_type]) {
+                uint64_t time_us;
+                memcpy(&time_us, &msg[3], sizeof(time_us));
+                if (time_index.count == 0 || time_us >= last_index_us + 1000000U) {
+                    if (!time_index.append(ofs, time_us)) {
+                        return false;
+                    }
+                    last_index_us = time_us;
+                }
+            }
+        }
+        ofs += length;
+    }
+
+    ::printf("Indexed %" PRIu64 " bytes: %u FMT/PARM messages, %u time points\n",
+             ofs, (unsigned)state_index.count, (unsigned)time_index.count);
+    indexed = true;
+    return true;
+}
 
-    memcpy(msg, hdr, 3);
-    if (read_input(&msg[3], f.length-3) != f.length-3) {
+bool AP_LoggerFileReader::seek_time(uint64_t time_us)
+{
+    if (mapped == nullptr) {
+        ::printf("Seeking needs a log file which can be mapped\n");
+        return false;
+    }
+    if (!indexed && !build_index()) {
         return false;
     }
 
-    strncpy(type, f.name, 4);
-    type[4] = 0;
+    // find the last time point at or before time_us
+    uint32_t lo = 0;
+    uint32_t hi = time_index.count;
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (time_index.entries[mid].time_us <= time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return true;
+    }
+    const uint64_t target = time_index.entries[lo-1].offset;
+    if (target <= offset) {
+        // only seek forward
+        return true;
+    }
 
-    message_count++;
-    return handle_msg(f,msg);
+    // formats and parameters are needed whatever the start point
+    char type[5];
+    for (uint32_t i=0; i<state_index.count; i++) {
+        const uint64_t ofs = state_index.entries[i].offset;
+        if (ofs < offset) {
+            continue;
+        }
+        if (ofs >= target) {
+            break;
+        }
+        if (!dispatch_message(&mapped[ofs], type)) {
+            return false;
+        }
+    }
+    offset = target;
+    return true;
 }
@@ -14,6 +14,10 @@ public:
     bool open_log(const char *logfile);
     bool update(char type[5]);
 
+    // move forward to the first indexed message at or before time_us,
+    // delivering the FMT and PARM messages that are skipped over
+    bool seek_time(uint64_t time_us);
+
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
@@ -27,6 +31,38 @@ protected:
 
 private:
     ssize_t read_input(void *buf, size_t count);
+    uint8_t *next_message(void);
+    bool dispatch_message(uint8_t *msg, char type[5]);
+    bool build_index(void);
+
+    // the log is mapped read only when possible and messages are
+    // handed to the handlers in place, so handlers must not write to
+    // a message. Streams that can't be mapped are read into
+    // stream_buf instead
+    uint8_t *mapped = nullptr;
+    uint64_t mapped_size = 0;
+    uint64_t offset = 0;
+    uint8_t stream_buf[256];
+
+    /*
+      a growable list of file offsets, optionally with a timestamp
+     */
+    struct offset_list {
+        struct entry {
+            uint64_t offset;
+            uint64_t time_us;
+        } *entries;
+        uint32_t count;
+        uint32_t space;
+        bool append(uint64_t offset, uint64_t time_us);
+    };
+
+    // built on the first seek: FMT and PARM messages which have to
+    // be delivered even when seeking past them, and the offset of the
+    // first timestamped message in each second of the log
+    bool indexed = false;
+    struct offset_list state_index {};
+    struct offset_list time_index {};
 
     uint64_t bytes_read = 0;
     uint32_t message_count = 0;
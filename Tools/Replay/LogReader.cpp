@@ -418,9 +418,13 @@ bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
             printf("Unknown msgid %u\n", (unsigned)msg[2]);
             exit(1);
         }
-        msg[2] = mapped_msgid[msg[2]];
         if (!in_list(name, nottypes)) {
-            logger.WriteBlock(msg, f.length);        
+            // the input message may be in the read only log mapping,
+            // so change the ID on a copy
+            uint8_t out[UINT8_MAX];
+            memcpy(out, msg, f.length);
+            out[2] = mapped_msgid[msg[2]];
+            logger.WriteBlock(out, f.length);
         }
         // a MsgHandler would probably have found a timestamp and
         // caled stop_clock.  This runs IO, clearing logger's
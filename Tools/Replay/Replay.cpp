@@ -34,6 +34,11 @@
 #include <SITL/SITL.h>
 #endif
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
 #define streq(x, y) (!strcmp(x, y))
 
 const AP_HAL::HAL& hal = AP_HAL::get_HAL();
@@ -153,6 +158,10 @@ void Replay::usage(void)
     ::printf("\t--no-params        don't use parameters from the log\n");
     ::printf("\t--no-fpe           do not generate floating point exceptions\n");
     ::printf("\t--packet-counts    print packet counts at end of processing\n");
+    ::printf("\t--seek SECONDS     skip to SECONDS since boot in the log before replaying\n");
+    ::printf("\t--batch DIR        replay all logs in DIR in parallel and summarise innovations\n");
+    ::printf("\t--jobs N           number of logs to replay at once in batch mode (default all cores)\n");
+    ::printf("\t--innovation-summary FILE  write an EKF innovation summary to FILE at end of log\n");
 }
 
 
@@ -169,6 +178,10 @@ enum {
     OPT_PARAM_FILE,
     OPT_NO_FPE,
     OPT_PACKET_COUNTS,
+    OPT_SEEK,
+    OPT_BATCH,
+    OPT_JOBS,
+    OPT_INNOVATION_SUMMARY,
 };
 
 void Replay::flush_logger(void) {
@@ -226,6 +239,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"no-params",       false,  0, OPT_NOPARAMS},
         {"no-fpe",          false,  0, OPT_NO_FPE},
         {"packet-counts",   false,  0, OPT_PACKET_COUNTS},
+        {"seek",            true,   0, OPT_SEEK},
+        {"batch",           true,   0, OPT_BATCH},
+        {"jobs",            true,   0, OPT_JOBS},
+        {"innovation-summary", true, 0, OPT_INNOVATION_SUMMARY},
         {0, false, 0, 0}
     };
 
@@ -313,6 +330,22 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             packet_counts = true;
             break;
 
+        case OPT_SEEK:
+            seek_time_s = atof(gopt.optarg);
+            break;
+
+        case OPT_BATCH:
+            batch_dir = gopt.optarg;
+            break;
+
+        case OPT_JOBS:
+            batch_jobs = atoi(gopt.optarg);
+            break;
+
+        case OPT_INNOVATION_SUMMARY:
+            innovation_summary = gopt.optarg;
+            break;
+
         case 'h':
         default:
             usage();
@@ -324,6 +357,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
 	argc -= gopt.optind;
 
     if (argc > 0) {
+        if (batch_dir != nullptr) {
+            ::printf("--batch replays the logs in DIR, no log filename is needed\n");
+            exit(1);
+        }
         filename = argv[0];
     }
 }
@@ -509,6 +546,10 @@ void Replay::setup()
 
     _parse_command_line(argc, argv);
 
+    if (batch_dir != nullptr) {
+        run_batch(argc, argv);
+    }
+
     if (!check_generate) {
         logreader.set_save_chek_messages(true);
     }
@@ -548,6 +589,13 @@ void Replay::setup()
     }
     
     set_ins_update_rate(log_info.update_rate);
+
+    if (seek_time_s > 0) {
+        hal.console->printf("Seeking to %.1f seconds\n", seek_time_s);
+        if (!logreader.seek_time(seek_time_s * 1.0e6f)) {
+            exit(1);
+        }
+    }
 }
 
 void Replay::set_ins_update_rate(uint16_t _update_rate) {
@@ -696,6 +744,9 @@ void Replay::read_sensors(const char *type)
     
     if (run_ahrs) {
         _vehicle.ahrs.update();
+        if (innovation_summary != nullptr) {
+            update_innovation_stats();
+        }
         if ((downsample == 0 || ++output_counter % downsample == 0) && !logmatch) {
             write_ekf_logs();
         }
@@ -782,6 +833,10 @@ void Replay::flush_and_exit()
 {
     flush_logger();
 
+    if (innovation_summary != nullptr) {
+        write_innovation_summary();
+    }
+
     if (check_solution) {
         report_checks();
     }
@@ -810,6 +865,360 @@ void Replay::show_packet_counts()
     printf("%" PRIu64 " total\n", total);
 }
 
+static const char *innovation_ekf_names[2] = { "EKF2", "EKF3" };
+
+/*
+  accumulate the innovations of the primary core of each EKF
+ */
+void Replay::update_innovation_stats(void)
+{
+    Vector3f velInnov, posInnov, magInnov;
+    float tasInnov, yawInnov;
+
+    if (_vehicle.EKF2.activeCores() > 0) {
+        _vehicle.EKF2.getInnovations(-1, velInnov, posInnov, magInnov, tasInnov, yawInnov);
+        accumulate_innovations(innov_stats[0], velInnov, posInnov, magInnov);
+    }
+    if (_vehicle.EKF3.activeCores() > 0) {
+        _vehicle.EKF3.getInnovations(-1, velInnov, posInnov, magInnov, tasInnov, yawInnov);
+        accumulate_innovations(innov_stats[1], velInnov, posInnov, magInnov);
+    }
+}
+
+void Replay::accumulate_innovations(struct innovation_stats &stats,
+                                    const Vector3f &velInnov, const Vector3f &posInnov,
+                                    const Vector3f &magInnov)
+{
+    const float vel = velInnov.length();
+    const float pos = norm(posInnov.x, posInnov.y);
+    const float hgt = fabsf(posInnov.z);
+    const float mag = magInnov.length();
+
+    stats.count++;
+    stats.vel_sq += sq(vel);
+    stats.pos_sq += sq(pos);
+    stats.hgt_sq += sq(hgt);
+    stats.mag_sq += sq(mag);
+    stats.vel_max = MAX(stats.vel_max, vel);
+    stats.pos_max = MAX(stats.pos_max, pos);
+    stats.hgt_max = MAX(stats.hgt_max, hgt);
+    stats.mag_max = MAX(stats.mag_max, mag);
+}
+
+/*
+  write the innovation summary for this log, one line per EKF
+ */
+void Replay::write_innovation_summary(void)
+{
+    FILE *f = xfopen(innovation_summary, "w");
+    fprintf(f, "# ekf samples vel_rms vel_max pos_rms pos_max hgt_rms hgt_max mag_rms mag_max\n");
+    for (uint8_t i=0; i<ARRAY_SIZE(innov_stats); i++) {
+        const struct innovation_stats &stats = innov_stats[i];
+        if (stats.count == 0) {
+            continue;
+        }
+        fprintf(f, "%s %lu %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f\n",
+                innovation_ekf_names[i],
+                (unsigned long)stats.count,
+                sqrt(stats.vel_sq / stats.count), stats.vel_max,
+                sqrt(stats.pos_sq / stats.count), stats.pos_max,
+                sqrt(stats.hgt_sq / stats.count), stats.hgt_max,
+                sqrt(stats.mag_sq / stats.count), stats.mag_max);
+    }
+    fclose(f);
+}
+
+/*
+  read back an innovation summary written by a batch job
+ */
+bool Replay::read_innovation_summary(const char *path, struct innovation_stats stats[2])
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        return false;
+    }
+    char line[200];
+    while (fgets(line, sizeof(line), f)) {
+        char name[5];
+        unsigned long count;
+        float vel_rms, vel_max, pos_rms, pos_max, hgt_rms, hgt_max, mag_rms, mag_max;
+        if (line[0] == '#' ||
+            sscanf(line, "%4s %lu %f %f %f %f %f %f %f %f", name, &count,
+                   &vel_rms, &vel_max, &pos_rms, &pos_max,
+                   &hgt_rms, &hgt_max, &mag_rms, &mag_max) != 10) {
+            continue;
+        }
+        for (uint8_t i=0; i<ARRAY_SIZE(innovation_ekf_names); i++) {
+            if (!streq(name, innovation_ekf_names[i])) {
+                continue;
+            }
+            struct innovation_stats &s = stats[i];
+            s.count = count;
+            s.vel_sq = sq(vel_rms) * count;
+            s.pos_sq = sq(pos_rms) * count;
+            s.hgt_sq = sq(hgt_rms) * count;
+            s.mag_sq = sq(mag_rms) * count;
+            s.vel_max = vel_max;
+            s.pos_max = pos_max;
+            s.hgt_max = hgt_max;
+            s.mag_max = mag_max;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+void Replay::print_innovation_stats(FILE *f, const char *logname, const char *status,
+                                    const struct innovation_stats stats[2])
+{
+    bool printed = false;
+    for (uint8_t i=0; i<ARRAY_SIZE(innovation_ekf_names); i++) {
+        const struct innovation_stats &s = stats[i];
+        if (s.count == 0) {
+            continue;
+        }
+        printed = true;
+        fprintf(f, "%-24s %-6s %s %9lu %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f\n",
+                logname, status, innovation_ekf_names[i], (unsigned long)s.count,
+                sqrt(s.vel_sq / s.count), s.vel_max,
+                sqrt(s.pos_sq / s.count), s.pos_max,
+                sqrt(s.hgt_sq / s.count), s.hgt_max,
+                sqrt(s.mag_sq / s.count), s.mag_max);
+    }
+    if (!printed) {
+        fprintf(f, "%-24s %-6s\n", logname, status);
+    }
+}
+
+/*
+  start a Replay child process on one log of a batch. Each child is a
+  fresh exec of this program running in its own directory, so its
+  vehicle state, output log, parameter storage and console output are
+  isolated from the other jobs
+ */
+pid_t Replay::start_batch_job(char * const argv[], const char *workdir)
+{
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    if (chdir(workdir) != 0) {
+        _exit(1);
+    }
+    int fd = open("replay.txt", O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if (fd != -1) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+    }
+    execv("/proc/self/exe", argv);
+    _exit(1);
+}
+
+static int batch_log_compare(const void *a, const void *b)
+{
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+/*
+  options naming an input file, which have to be made absolute for
+  batch children as they run in their own directories
+ */
+static const char *batch_path_options[] = {
+    "--param-file",
+};
+
+/*
+  return an absolute copy of a path option's value, exiting if the
+  file can't be found
+ */
+static char *batch_abs_path(const char *path)
+{
+    char *abs = realpath(path, nullptr);
+    if (abs == nullptr) {
+        ::printf("Failed to find %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    return abs;
+}
+
+/*
+  replay every log in batch_dir, running up to batch_jobs logs at once,
+  then print and save an innovation summary covering all of them
+ */
+void Replay::run_batch(uint8_t argc, char * const argv[])
+{
+    char *dir = realpath(batch_dir, nullptr);
+    DIR *d = dir ? opendir(dir) : nullptr;
+    if (d == nullptr) {
+        ::printf("Failed to open batch directory %s: %s\n", batch_dir, strerror(errno));
+        exit(1);
+    }
+    char **logs = nullptr;
+    uint16_t nlogs = 0;
+    for (struct dirent *de=readdir(d); de; de=readdir(d)) {
+        const char *ext = strrchr(de->d_name, '.');
+        if (ext == nullptr || strcasecmp(ext, ".bin") != 0) {
+            continue;
+        }
+        char **new_logs = (char **)realloc(logs, (nlogs+1) * sizeof(char *));
+        if (new_logs == nullptr) {
+            break;
+        }
+        logs = new_logs;
+        logs[nlogs++] = strdup(de->d_name);
+    }
+    closedir(d);
+    if (nlogs == 0) {
+        ::printf("No logs found in %s\n", batch_dir);
+        exit(1);
+    }
+    qsort(logs, nlogs, sizeof(char *), batch_log_compare);
+
+    if (batch_jobs == 0) {
+        batch_jobs = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+    }
+
+    // the children get our arguments less the batch options, with an
+    // innovation summary request and the log to replay on the end
+    char **child_argv = (char **)calloc(argc + 4, sizeof(char *));
+    uint8_t child_argc = 0;
+    child_argv[child_argc++] = argv[0];
+    for (uint8_t i=1; i<argc; i++) {
+        if (streq(argv[i], "--batch") ||
+            streq(argv[i], "--jobs") ||
+            streq(argv[i], "--innovation-summary")) {
+            i++;
+            continue;
+        }
+        if (strncmp(argv[i], "--batch=", 8) == 0 ||
+            strncmp(argv[i], "--jobs=", 7) == 0 ||
+            strncmp(argv[i], "--innovation-summary=", 21) == 0) {
+            continue;
+        }
+        child_argv[child_argc++] = argv[i];
+        for (uint8_t j=0; j<ARRAY_SIZE(batch_path_options); j++) {
+            const char *opt = batch_path_options[j];
+            const size_t len = strlen(opt);
+            if (streq(argv[i], opt) && i+1 < argc) {
+                i++;
+                child_argv[child_argc++] = batch_abs_path(argv[i]);
+                break;
+            }
+            if (strncmp(argv[i], opt, len) == 0 && argv[i][len] == '=') {
+                char *abs = batch_abs_path(&argv[i][len+1]);
+                if (asprintf(&child_argv[child_argc-1], "%s=%s", opt, abs) == -1) {
+                    ::printf("Out of memory\n");
+                    exit(1);
+                }
+                free(abs);
+                break;
+            }
+        }
+    }
+    child_argv[child_argc++] = (char *)"--innovation-summary";
+    child_argv[child_argc++] = (char *)"innovations.txt";
+    const uint8_t log_arg = child_argc;
+
+    mkdir("replay_batch", 0755);
+
+    pid_t *pids = (pid_t *)calloc(nlogs, sizeof(pid_t));
+    int *status = (int *)calloc(nlogs, sizeof(int));
+    uint16_t next = 0;
+    uint16_t running = 0;
+
+    ::printf("Replaying %u logs from %s with %u jobs\n",
+             (unsigned)nlogs, dir, (unsigned)batch_jobs);
+
+    while (next < nlogs || running > 0) {
+        while (running < batch_jobs && next < nlogs) {
+            char *logpath = nullptr;
+            char *workdir = nullptr;
+            if (asprintf(&logpath, "%s/%s", dir, logs[next]) == -1 ||
+                asprintf(&workdir, "replay_batch/%s", logs[next]) == -1) {
+                ::printf("Out of memory\n");
+                exit(1);
+            }
+            mkdir(workdir, 0755);
+            child_argv[log_arg] = logpath;
+            pids[next] = start_batch_job(child_argv, workdir);
+            free(logpath);
+            free(workdir);
+            if (pids[next] == -1) {
+                ::printf("Failed to start replay of %s: %s\n", logs[next], strerror(errno));
+                status[next] = -1;
+            } else {
+                running++;
+            }
+            next++;
+        }
+        if (running == 0) {
+            break;
+        }
+        int wstatus;
+        const pid_t pid = wait(&wstatus);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (uint16_t i=0; i<next; i++) {
+            if (pids[i] == pid) {
+                status[i] = wstatus;
+                ::printf("Finished %s (%u/%u)\n", logs[i], (unsigned)i+1, (unsigned)nlogs);
+                break;
+            }
+        }
+        running--;
+    }
+
+    FILE *results = xfopen("replay_batch_results.txt", "w");
+    FILE *outputs[2] = { stdout, results };
+    for (FILE *f : outputs) {
+        fprintf(f, "%-24s %-6s %s %9s %7s %7s %7s %7s %7s %7s %7s %7s\n",
+                "Log", "Status", "EKF ", "Samples",
+                "VelRMS", "VelMax", "PosRMS", "PosMax",
+                "HgtRMS", "HgtMax", "MagRMS", "MagMax");
+    }
+
+    struct innovation_stats total[2] {};
+    uint16_t failed = 0;
+    for (uint16_t i=0; i<nlogs; i++) {
+        struct innovation_stats stats[2] {};
+        char *path = nullptr;
+        bool ok = (status[i] != -1 &&
+                   WIFEXITED(status[i]) && WEXITSTATUS(status[i]) == 0 &&
+                   asprintf(&path, "replay_batch/%s/innovations.txt", logs[i]) != -1 &&
+                   read_innovation_summary(path, stats));
+        free(path);
+        if (!ok) {
+            failed++;
+        }
+        for (FILE *f : outputs) {
+            print_innovation_stats(f, logs[i], ok?"OK":"FAILED", stats);
+        }
+        for (uint8_t j=0; j<ARRAY_SIZE(total); j++) {
+            total[j].count += stats[j].count;
+            total[j].vel_sq += stats[j].vel_sq;
+            total[j].pos_sq += stats[j].pos_sq;
+            total[j].hgt_sq += stats[j].hgt_sq;
+            total[j].mag_sq += stats[j].mag_sq;
+            total[j].vel_max = MAX(total[j].vel_max, stats[j].vel_max);
+            total[j].pos_max = MAX(total[j].pos_max, stats[j].pos_max);
+            total[j].hgt_max = MAX(total[j].hgt_max, stats[j].hgt_max);
+            total[j].mag_max = MAX(total[j].mag_max, stats[j].mag_max);
+        }
+    }
+    for (FILE *f : outputs) {
+        print_innovation_stats(f, "TOTAL", failed?"FAILED":"OK", total);
+        fprintf(f, "%u of %u logs replayed, results in replay_batch/\n",
+                (unsigned)(nlogs - failed), (unsigned)nlogs);
+    }
+    fclose(results);
+
+    exit(failed ? 1 : 0);
+}
+
 void Replay::loop()
 {
     char type[5];
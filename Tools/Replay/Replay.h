@@ -149,6 +149,29 @@ private:
     uint32_t output_counter = 0;
     uint64_t last_timestamp = 0;
     bool packet_counts = false;
+    float seek_time_s = 0;
+
+    // batch mode: replay every log in batch_dir in a separate process
+    const char *batch_dir = nullptr;
+    uint16_t batch_jobs = 0;
+
+    // file to write the innovation summary to at the end of the log
+    const char *innovation_summary = nullptr;
+
+    /*
+      running innovation statistics for one EKF
+     */
+    struct innovation_stats {
+        uint32_t count;
+        double vel_sq;
+        double pos_sq;
+        double hgt_sq;
+        double mag_sq;
+        float vel_max;
+        float pos_max;
+        float hgt_max;
+        float mag_max;
+    } innov_stats[2] {};
 
     struct {
         float max_roll_error;
@@ -184,6 +207,16 @@ private:
     bool parse_param_line(char *line, char **vname, float &value);
     void load_param_file(const char *filename);
     void set_signal_handlers(void);
+    void update_innovation_stats(void);
+    void accumulate_innovations(struct innovation_stats &stats,
+                                const Vector3f &velInnov, const Vector3f &posInnov,
+                                const Vector3f &magInnov);
+    void write_innovation_summary(void);
+    void run_batch(uint8_t argc, char * const argv[]);
+    pid_t start_batch_job(char * const argv[], const char *workdir);
+    bool read_innovation_summary(const char *path, struct innovation_stats stats[2]);
+    void print_innovation_stats(FILE *f, const char *logname, const char *status,
+                                const struct innovation_stats stats[2]);
     void flush_and_exit();
 
     FILE *xfopen(const char *f, const char *mode);
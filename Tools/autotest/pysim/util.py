@@ -241,7 +241,8 @@ def start_SITL(binary,
                breakpoints=[],
                disable_breakpoints=False,
                vicon=False,
-               lldb=False):
+               lldb=False,
+               lockstep=False):
     """Launch a SITL instance."""
     cmd = []
     if valgrind and os.path.exists('/usr/bin/valgrind'):
@@ -314,6 +315,8 @@ def start_SITL(binary,
         cmd.extend(['--model', model])
     if speedup != 1:
         cmd.extend(['--speedup', str(speedup)])
+    if lockstep:
+        cmd.append('--lockstep')
     if defaults_file is not None:
         cmd.extend(['--defaults', defaults_file])
     if unhide_parameters:
@@ -4,6 +4,7 @@
 
 #include "AP_HAL_Namespace.h"
 #include "utility/BetterStream.h"
+#include "utility/RingBuffer.h"
 
 /* Pure virtual UARTDriver class */
 class AP_HAL::UARTDriver : public AP_HAL::BetterStream {
@@ -47,6 +48,18 @@ public:
 
     // read from a locked port. If port is locked and key is not correct then 0 is returned
     virtual int16_t read_locked(uint32_t key) { return -1; }
+
+    /*
+      reserve len bytes in the transmit buffer so a packet can be
+      serialised straight into it rather than passed to write(). On
+      success vec holds one or two spans covering the len bytes, and
+      the port's write lock is held until tx_commit() is called with
+      the number of bytes filled in (zero abandons the reservation).
+      Returns the number of spans, or zero if the port can't take
+      all len bytes now or does not support this
+     */
+    virtual uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) { return 0; }
+    virtual void tx_commit(uint32_t len) {}
     
     // control optional features
     virtual bool set_options(uint8_t options) { return options==0; }
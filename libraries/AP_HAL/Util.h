@@ -146,6 +146,23 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    /*
+      execution time statistics, since boot, of a HAL thread or of a
+      callback run by one
+     */
+    struct TimingStats {
+        char name[16];
+        uint32_t count;         // number of runs
+        uint32_t min_us;
+        uint32_t mean_us;
+        uint32_t max_us;
+        uint32_t p99_us;        // 99th percentile, from a histogram
+        uint32_t overruns;      // runs that took longer than their period
+    };
+
+    // get the statistics for entry idx. Returns false past the last entry
+    virtual bool get_timing_stats(uint8_t idx, TimingStats &stats) { return false; }
+
     // allocate and free DMA-capable memory if possible. Otherwise return normal memory
     enum Memory_Type {
         MEM_DMA_SAFE,
@@ -0,0 +1,150 @@
+#include <AP_gtest.h>
+
+#include <thread>
+#include <AP_HAL/utility/SPSCByteBuffer.h>
+
+TEST(SPSCByteBufferTest, WrapAround)
+{
+    SPSCByteBuffer b(8);
+    uint8_t out[8];
+
+    EXPECT_EQ(b.space(), 7u);
+    EXPECT_EQ(b.write((const uint8_t *)"abcde", 5), 5u);
+    EXPECT_EQ(b.read(out, 4), 4u);
+    EXPECT_EQ(memcmp(out, "abcd", 4), 0);
+
+    // wraps the end of the buffer
+    EXPECT_EQ(b.write((const uint8_t *)"fghijk", 6), 6u);
+    EXPECT_EQ(b.available(), 7u);
+    EXPECT_EQ(b.space(), 0u);
+
+    SPSCByteBuffer::IoVec vec[2];
+    EXPECT_EQ(b.peekiovec(vec, 7), 2);
+    EXPECT_EQ(vec[0].len + vec[1].len, 7u);
+
+    uint32_t n;
+    const uint8_t *p = b.readptr(n);
+    EXPECT_EQ(n, 4u);
+    EXPECT_EQ(memcmp(p, "efgh", 4), 0);
+    EXPECT_TRUE(b.advance(n));
+
+    EXPECT_EQ(b.read(out, 8), 3u);
+    EXPECT_EQ(memcmp(out, "ijk", 3), 0);
+    EXPECT_TRUE(b.empty());
+}
+
+TEST(SPSCByteBufferTest, Spans)
+{
+    SPSCByteBuffer b(8);
+
+    // with the reader at the start one byte is kept free
+    uint32_t n;
+    uint8_t *p = b.writeptr(n);
+    EXPECT_EQ(n, 7u);
+    memcpy(p, "abc", 3);
+    EXPECT_TRUE(b.commit(3));
+    EXPECT_FALSE(b.commit(5));
+
+    EXPECT_EQ(b.peek(2), 'c');
+    EXPECT_EQ(b.peek(3), -1);
+    EXPECT_TRUE(b.advance(3));
+
+    // up to the end of the buffer, then the start up to the reader
+    p = b.writeptr(n);
+    EXPECT_EQ(n, 5u);
+    memcpy(p, "defgh", 5);
+    EXPECT_TRUE(b.commit(5));
+    uint8_t *start = b.writeptr(n);
+    EXPECT_EQ(n, 2u);
+    EXPECT_EQ(start + 3, p);
+
+    const uint8_t *r = b.readptr(n);
+    EXPECT_EQ(n, 5u);
+    EXPECT_EQ(memcmp(r, "defgh", 5), 0);
+}
+
+TEST(SPSCByteBufferTest, Stats)
+{
+    SPSCByteBuffer b(16);
+    uint8_t data[20] {};
+
+    EXPECT_EQ(b.write(data, 10), 10u);
+    EXPECT_EQ(b.get_high_water(), 10u);
+    EXPECT_TRUE(b.advance(8));
+    EXPECT_EQ(b.write(data, 4), 4u);
+    EXPECT_EQ(b.get_high_water(), 10u);
+
+    EXPECT_EQ(b.write(data, 20), 9u);
+    EXPECT_EQ(b.get_high_water(), 15u);
+    EXPECT_EQ(b.get_overflow_bytes(), 11u);
+
+    b.reset_stats();
+    EXPECT_EQ(b.get_high_water(), 0u);
+    EXPECT_EQ(b.get_overflow_bytes(), 0u);
+}
+
+/*
+  one thread writes a known sequence in odd sized pieces while
+  another reads it back, checking nothing is lost, duplicated or
+  reordered
+ */
+TEST(SPSCByteBufferTest, Stress)
+{
+    const uint32_t total = 1000000;
+    SPSCByteBuffer b(1031);
+
+    std::thread writer([&b, total]() {
+        uint32_t seq = 0;
+        uint8_t chunk[97];
+        while (seq < total) {
+            uint32_t len = 1 + (seq % sizeof(chunk));
+            if (len > total - seq) {
+                len = total - seq;
+            }
+            for (uint32_t i = 0; i < len; i++) {
+                chunk[i] = uint8_t((seq + i) * 7);
+            }
+            if (seq & 1) {
+                seq += b.write(chunk, len);
+                continue;
+            }
+            SPSCByteBuffer::IoVec vec[2];
+            const uint8_t n_vec = b.reserve(vec, len);
+            uint32_t n = 0;
+            for (uint8_t i = 0; i < n_vec; i++) {
+                memcpy(vec[i].data, &chunk[n], vec[i].len);
+                n += vec[i].len;
+            }
+            b.commit(n);
+            seq += n;
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t seq = 0;
+    uint32_t errors = 0;
+    while (seq < total) {
+        uint32_t n;
+        const uint8_t *p = b.readptr(n);
+        if (p == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (p[i] != uint8_t((seq + i) * 7)) {
+                errors++;
+            }
+        }
+        seq += n;
+        b.advance(n);
+    }
+    writer.join();
+
+    EXPECT_EQ(errors, 0u);
+    EXPECT_TRUE(b.empty());
+    EXPECT_LE(b.get_high_water(), 1030u);
+}
+
+AP_GTEST_MAIN()
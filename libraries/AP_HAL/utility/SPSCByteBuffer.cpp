@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "SPSCByteBuffer.h"
+
+SPSCByteBuffer::SPSCByteBuffer(uint32_t _size)
+{
+    buf = (uint8_t*)calloc(1, _size);
+    size = buf ? _size : 0;
+}
+
+SPSCByteBuffer::~SPSCByteBuffer(void)
+{
+    free(buf);
+}
+
+bool SPSCByteBuffer::set_size(uint32_t _size)
+{
+    clear();
+    if (_size != size) {
+        free(buf);
+        buf = (uint8_t*)calloc(1, _size);
+        if (!buf) {
+            size = 0;
+            return false;
+        }
+
+        size = _size;
+    }
+
+    return true;
+}
+
+void SPSCByteBuffer::clear(void)
+{
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_release);
+}
+
+uint32_t SPSCByteBuffer::available(void) const
+{
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    return used(_head, _tail);
+}
+
+uint32_t SPSCByteBuffer::space(void) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    return size - 1 - available();
+}
+
+bool SPSCByteBuffer::empty(void) const
+{
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+/*
+  writer side
+ */
+
+uint32_t SPSCByteBuffer::write(const uint8_t *data, uint32_t len)
+{
+    IoVec vec[2];
+    const uint8_t n_vec = reserve(vec, len);
+    uint32_t ret = 0;
+
+    for (uint8_t i = 0; i < n_vec; i++) {
+        memcpy(vec[i].data, data + ret, vec[i].len);
+        ret += vec[i].len;
+    }
+
+    commit(ret);
+
+    if (ret < len) {
+        overflow_bytes.store(overflow_bytes.load(std::memory_order_relaxed) + (len - ret),
+                             std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+uint8_t *SPSCByteBuffer::writeptr(uint32_t &space_bytes)
+{
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    const uint32_t _head = head.load(std::memory_order_acquire);
+
+    if (size == 0) {
+        space_bytes = 0;
+    } else if (_head > _tail) {
+        space_bytes = _head - _tail - 1;
+    } else {
+        // up to the end of the buffer, keeping one byte free if the
+        // reader is at the start
+        space_bytes = size - _tail - (_head == 0 ? 1 : 0);
+    }
+
+    return space_bytes ? &buf[_tail] : nullptr;
+}
+
+uint8_t SPSCByteBuffer::reserve(IoVec vec[2], uint32_t len)
+{
+    const uint32_t n = space();
+
+    if (len > n) {
+        len = n;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    vec[0].data = &buf[_tail];
+
+    const uint32_t to_end = size - _tail;
+    if (len <= to_end) {
+        vec[0].len = len;
+        return 1;
+    }
+
+    vec[0].len = to_end;
+    vec[1].data = buf;
+    vec[1].len = len - to_end;
+
+    return 2;
+}
+
+bool SPSCByteBuffer::commit(uint32_t len)
+{
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    const uint32_t _head = head.load(std::memory_order_acquire);
+
+    if (len > size - 1 - used(_head, _tail)) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+
+    const uint32_t new_tail = (_tail + len) % size;
+
+    const uint32_t n = used(_head, new_tail);
+    if (n > high_water.load(std::memory_order_relaxed)) {
+        high_water.store(n, std::memory_order_relaxed);
+    }
+
+    // publishes the bytes written before it to the reader
+    tail.store(new_tail, std::memory_order_release);
+    return true;
+}
+
+void SPSCByteBuffer::reset_stats(void)
+{
+    high_water.store(0, std::memory_order_relaxed);
+    overflow_bytes.store(0, std::memory_order_relaxed);
+}
+
+/*
+  reader side
+ */
+
+uint32_t SPSCByteBuffer::read(uint8_t *data, uint32_t len)
+{
+    const uint32_t ret = peekbytes(data, len);
+    advance(ret);
+    return ret;
+}
+
+bool SPSCByteBuffer::read_byte(uint8_t *data)
+{
+    if (!data) {
+        return false;
+    }
+
+    const int16_t ret = peek(0);
+    if (ret < 0) {
+        return false;
+    }
+
+    *data = ret;
+
+    return advance(1);
+}
+
+const uint8_t *SPSCByteBuffer::readptr(uint32_t &available_bytes)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+
+    available_bytes = (_head > _tail) ? size - _head : _tail - _head;
+
+    return available_bytes ? &buf[_head] : nullptr;
+}
+
+uint8_t SPSCByteBuffer::peekiovec(IoVec vec[2], uint32_t len)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t n = used(_head, _tail);
+
+    if (len > n) {
+        len = n;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    vec[0].data = &buf[_head];
+
+    const uint32_t to_end = size - _head;
+    if (len <= to_end) {
+        vec[0].len = len;
+        return 1;
+    }
+
+    vec[0].len = to_end;
+    vec[1].data = buf;
+    vec[1].len = len - to_end;
+
+    return 2;
+}
+
+uint32_t SPSCByteBuffer::peekbytes(uint8_t *data, uint32_t len)
+{
+    IoVec vec[2];
+    const uint8_t n_vec = peekiovec(vec, len);
+    uint32_t ret = 0;
+
+    for (uint8_t i = 0; i < n_vec; i++) {
+        memcpy(data + ret, vec[i].data, vec[i].len);
+        ret += vec[i].len;
+    }
+
+    return ret;
+}
+
+int16_t SPSCByteBuffer::peek(uint32_t ofs) const
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+
+    if (ofs >= used(_head, _tail)) {
+        return -1;
+    }
+    return buf[(_head + ofs) % size];
+}
+
+bool SPSCByteBuffer::advance(uint32_t n)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+
+    if (n > used(_head, _tail)) {
+        return false;
+    }
+    if (n == 0) {
+        return true;
+    }
+
+    // hands the space back to the writer once we are done with it
+    head.store((_head + n) % size, std::memory_order_release);
+    return true;
+}
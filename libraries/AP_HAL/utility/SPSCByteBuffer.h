@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "RingBuffer.h"
+
+/*
+  circular buffer of bytes for exactly one writer thread and one
+  reader thread, such as a UART's driver thread and the thread using
+  the UART. Neither side takes a lock: each side only stores its own
+  index, publishing it with release ordering, and reads the other
+  side's index with acquire ordering. That is what makes the bytes
+  behind an index visible to the other thread before the index itself.
+
+  Methods are marked as writer or reader side. Several threads may
+  write (or read) as long as they serialise themselves, for example
+  with a semaphore, so that only one is active at a time. available()
+  and space() can be called from either side and are exact from the
+  side that owns the buffer's other end.
+ */
+class SPSCByteBuffer {
+public:
+    typedef ByteBuffer::IoVec IoVec;
+
+    SPSCByteBuffer(uint32_t size);
+    ~SPSCByteBuffer(void);
+
+    // set size of ringbuffer, emptying it. Neither side may be active
+    bool set_size(uint32_t size);
+
+    // discard the buffer content. Neither side may be active
+    void clear(void);
+
+    // return size of ringbuffer. It holds up to size-1 bytes
+    uint32_t get_size(void) const { return size; }
+
+    // number of bytes available to be read
+    uint32_t available(void) const;
+
+    // number of bytes space available to write
+    uint32_t space(void) const;
+
+    // true if available() is zero
+    bool empty(void) const;
+
+    /*
+      writer side
+     */
+
+    // write bytes to ringbuffer. Returns number of bytes written
+    uint32_t write(const uint8_t *data, uint32_t len);
+
+    // get the next contiguous span that can be written, or nullptr
+    // if the buffer is full. Follow with commit()
+    uint8_t *writeptr(uint32_t &space_bytes);
+
+    // get up to len bytes of space as one or two spans. Returns the
+    // number of spans filled out. Follow with commit()
+    uint8_t reserve(IoVec vec[2], uint32_t len);
+
+    // make len bytes written to the reserved space visible to the
+    // reader. Returns false if len is more than the space there is
+    bool commit(uint32_t len);
+
+    /*
+      reader side
+     */
+
+    // read bytes from ringbuffer. Returns number of bytes read
+    uint32_t read(uint8_t *data, uint32_t len);
+
+    // read a byte from ring buffer. Returns true on success, false otherwise
+    bool read_byte(uint8_t *data);
+
+    // get the next contiguous span that can be read, or nullptr if
+    // the buffer is empty. Follow with advance()
+    const uint8_t *readptr(uint32_t &available_bytes);
+
+    // get up to len bytes of data as one or two spans, without
+    // advancing the read pointer. Returns the number of spans
+    uint8_t peekiovec(IoVec vec[2], uint32_t len);
+
+    // read len bytes without advancing the read pointer
+    uint32_t peekbytes(uint8_t *data, uint32_t len);
+
+    // peek one byte without advancing read pointer. Return byte
+    // or -1 if none available
+    int16_t peek(uint32_t ofs) const;
+
+    // advance the read pointer (discarding bytes)
+    bool advance(uint32_t n);
+
+    /*
+      statistics, for sizing buffers
+     */
+
+    // most bytes that have been waiting to be read at once
+    uint32_t get_high_water(void) const { return high_water.load(std::memory_order_relaxed); }
+
+    // bytes write() could not fit in
+    uint32_t get_overflow_bytes(void) const { return overflow_bytes.load(std::memory_order_relaxed); }
+
+    void reset_stats(void);
+
+private:
+    uint8_t *buf;
+    uint32_t size;
+
+    std::atomic<uint32_t> head{0}; // where to read data, stored by the reader
+    std::atomic<uint32_t> tail{0}; // where to write data, stored by the writer
+
+    // updated by the writer
+    std::atomic<uint32_t> high_water{0};
+    std::atomic<uint32_t> overflow_bytes{0};
+
+    uint32_t used(uint32_t _head, uint32_t _tail) const {
+        return _head > _tail ? size - _head + _tail : _tail - _head;
+    }
+};
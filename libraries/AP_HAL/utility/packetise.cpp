@@ -11,7 +11,8 @@
 /*
   return the number of bytes to send for a packetised connection
  */
-uint16_t mavlink_packetise(ByteBuffer &writebuf, uint16_t n)
+template <typename T>
+static uint16_t packetise(T &writebuf, uint16_t n)
 {
     int16_t b = writebuf.peek(0);
     if (b != MAVLINK_STX_MAVLINK1 && b != MAVLINK_STX) {
@@ -67,4 +68,14 @@ uint16_t mavlink_packetise(ByteBuffer &writebuf, uint16_t n)
     }
     return n;
 }
+
+uint16_t mavlink_packetise(ByteBuffer &writebuf, uint16_t n)
+{
+    return packetise(writebuf, n);
+}
+
+uint16_t mavlink_packetise(SPSCByteBuffer &writebuf, uint16_t n)
+{
+    return packetise(writebuf, n);
+}
 #endif // HAL_BOOTLOADER_BUILD
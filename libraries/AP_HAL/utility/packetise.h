@@ -1,7 +1,11 @@
 #pragma once
 
+#include "RingBuffer.h"
+#include "SPSCByteBuffer.h"
+
 /*
   return the number of bytes to send for a packetised connection
 */
 uint16_t mavlink_packetise(ByteBuffer &writebuf, uint16_t n);
+uint16_t mavlink_packetise(SPSCByteBuffer &writebuf, uint16_t n);
 
@@ -635,6 +635,39 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
     return ret;
 }
 
+/*
+  reserve space for a whole packet in the write buffer. Blocking
+  buffered writes go through write() so they keep their per-byte wait
+ */
+uint8_t UARTDriver::tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (!_initialised || lock_write_key != 0 ||
+        (_blocking_writes && !unbuffered_writes)) {
+        return 0;
+    }
+    if (!_write_mutex.take_nonblocking()) {
+        return 0;
+    }
+    if (_writebuf.space() < len) {
+        _write_mutex.give();
+        return 0;
+    }
+    const uint8_t n_vec = _writebuf.reserve(vec, len);
+    if (n_vec == 0) {
+        _write_mutex.give();
+    }
+    return n_vec;
+}
+
+void UARTDriver::tx_commit(uint32_t len)
+{
+    _writebuf.commit(len);
+    if (unbuffered_writes) {
+        write_pending_bytes();
+    }
+    _write_mutex.give();
+}
+
 /*
   lock the uart for exclusive use by write_locked() and read_locked() with the right key
  */
@@ -61,6 +61,10 @@ public:
     // and write is discarded
     size_t write_locked(const uint8_t *buffer, size_t size, uint32_t key) override;
 
+    // write a packet straight into the write buffer
+    uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    void tx_commit(uint32_t len) override;
+
     struct SerialDef {
         BaseSequentialStream* serial;
         bool is_usb;
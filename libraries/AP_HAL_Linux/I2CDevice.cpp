@@ -253,7 +253,10 @@ AP_HAL::Semaphore *I2CDevice::get_semaphore()
 AP_HAL::Device::PeriodicHandle I2CDevice::register_periodic_callback(
     uint32_t period_usec, AP_HAL::Device::PeriodicCb cb)
 {
-    TimerPollable *p = _bus.thread.add_timer(cb, &_bus, period_usec);
+    char cb_name[16];
+    snprintf(cb_name, sizeof(cb_name), "i2c%u:%02x", _bus.bus, _address);
+
+    TimerPollable *p = _bus.thread.add_timer(cb, &_bus, period_usec, cb_name);
     if (!p) {
         AP_HAL::panic("Could not create periodic callback");
     }
@@ -41,7 +41,13 @@ void TimerPollable::on_can_read()
         _wrapper->start_cb();
     }
 
-    _cb();
+    if (_stats) {
+        const uint32_t start_us = AP_HAL::micros();
+        _cb();
+        _stats->sample(AP_HAL::micros() - start_us);
+    } else {
+        _cb();
+    }
 
     if (_wrapper) {
         _wrapper->end_cb();
@@ -88,7 +94,8 @@ bool TimerPollable::adjust_timer(uint32_t timeout_usec)
 
 TimerPollable *PollerThread::add_timer(TimerPollable::PeriodicCb cb,
                                        TimerPollable::WrapperCb *wrapper,
-                                       uint32_t timeout_usec)
+                                       uint32_t timeout_usec,
+                                       const char *name)
 {
     if (!_poller) {
         return nullptr;
@@ -100,6 +107,10 @@ TimerPollable *PollerThread::add_timer(TimerPollable::PeriodicCb cb,
         return nullptr;
     }
 
+    if (name != nullptr) {
+        p->_stats = TimingStats::create(name, timeout_usec);
+    }
+
     _timers.push_back(p);
 
     return p;
@@ -113,6 +124,10 @@ bool PollerThread::adjust_timer(TimerPollable *p, uint32_t timeout_usec)
         return false;
     }
 
+    if ((*it)->_stats) {
+        (*it)->_stats->set_period(timeout_usec);
+    }
+
     return (*it)->adjust_timer(timeout_usec);
 }
 
@@ -23,6 +23,7 @@
 
 #include "Poller.h"
 #include "Thread.h"
+#include "TimingStats.h"
 
 namespace Linux {
 
@@ -56,6 +57,7 @@ protected:
 
     PeriodicCb _cb;
     WrapperCb *_wrapper;
+    TimingStats *_stats = nullptr;
     bool _removeme = false;
 };
 
@@ -65,11 +67,22 @@ public:
     PollerThread() : Thread{FUNCTOR_BIND_MEMBER(&PollerThread::mainloop, void)} { }
     virtual ~PollerThread() { }
 
+    /*
+     * Add a timer running @cb every @timeout_usec. If @name is given the
+     * callback's execution time is recorded under that name.
+     */
     TimerPollable *add_timer(TimerPollable::PeriodicCb cb,
                              TimerPollable::WrapperCb *wrapper,
-                             uint32_t timeout_usec);
+                             uint32_t timeout_usec,
+                             const char *name = nullptr);
     bool adjust_timer(TimerPollable *p, uint32_t timeout_usec);
 
+    /*
+     * The poller this thread waits on, for registering other file
+     * descriptors to be handled in this thread.
+     */
+    Poller &get_poller() { return _poller; }
+
     void mainloop();
 
     bool stop() override;
@@ -410,7 +410,7 @@ AP_HAL::Semaphore *SPIDevice::get_semaphore()
 AP_HAL::Device::PeriodicHandle SPIDevice::register_periodic_callback(
     uint32_t period_usec, AP_HAL::Device::PeriodicCb cb)
 {
-    TimerPollable *p = _bus.thread.add_timer(cb, &_bus, period_usec);
+    TimerPollable *p = _bus.thread.add_timer(cb, &_bus, period_usec, _desc.name);
     if (!p) {
         AP_HAL::panic("Could not create periodic callback");
     }
@@ -92,7 +92,6 @@ void Scheduler::init()
         uint32_t rate;
     } sched_table[] = {
         SCHED_THREAD(timer, TIMER),
-        SCHED_THREAD(uart, UART),
         SCHED_THREAD(rcin, RCIN),
         SCHED_THREAD(io, IO),
     };
@@ -101,14 +100,18 @@ void Scheduler::init()
 
     init_realtime();
 
-    /* set barrier to N + 1 threads: worker threads + main */
-    unsigned n_threads = ARRAY_SIZE(sched_table) + 1;
+    /* set barrier to N + 2 threads: worker threads + uart + main */
+    unsigned n_threads = ARRAY_SIZE(sched_table) + 2;
     ret = pthread_barrier_init(&_initialized_barrier, nullptr, n_threads);
     if (ret) {
         AP_HAL::panic("Scheduler: Failed to initialise barrier object: %s",
                       strerror(ret));
     }
 
+    _timer_stats = TimingStats::create("timer", 1000000UL / APM_LINUX_TIMER_RATE);
+    _rcin_stats = TimingStats::create("rcin", 1000000UL / APM_LINUX_RCIN_RATE);
+    _io_stats = TimingStats::create("io", 1000000UL / APM_LINUX_IO_RATE);
+
     for (size_t i = 0; i < ARRAY_SIZE(sched_table); i++) {
         const struct sched_table *t = &sched_table[i];
 
@@ -117,6 +120,17 @@ void Scheduler::init()
         t->thread->start(t->name, t->policy, t->prio);
     }
 
+    /*
+      the UART thread wakes when a UART's device is ready. The tick
+      covers devices it can't wait on and reconnections
+     */
+    if (!_uart_thread.add_timer(FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void),
+                                nullptr, 1000000UL / APM_LINUX_UART_RATE, "uart")) {
+        AP_HAL::panic("Scheduler: failed to create UART timer");
+    }
+    _uart_thread.set_stack_size(1024 * 1024);
+    _uart_thread.start("ap-uart", SCHED_FIFO, APM_LINUX_UART_PRIORITY);
+
 #if defined(DEBUG_STACK) && DEBUG_STACK
     register_timer_process(FUNCTOR_BIND_MEMBER(&Scheduler::_debug_stack, void));
 #endif
@@ -186,7 +200,11 @@ void Scheduler::register_timer_process(AP_HAL::MemberProc proc)
         return;
     }
 
+    char name[16];
+    snprintf(name, sizeof(name), "timer%u", _num_timer_procs);
+
     _timer_proc[_num_timer_procs] = proc;
+    _timer_proc_stats[_num_timer_procs] = TimingStats::create(name, 1000000UL / APM_LINUX_TIMER_RATE);
     _num_timer_procs++;
 }
 
@@ -199,7 +217,11 @@ void Scheduler::register_io_process(AP_HAL::MemberProc proc)
     }
 
     if (_num_io_procs < LINUX_SCHEDULER_MAX_IO_PROCS) {
+        char name[16];
+        snprintf(name, sizeof(name), "io%u", _num_io_procs);
+
         _io_proc[_num_io_procs] = proc;
+        _io_proc_stats[_num_io_procs] = TimingStats::create(name, 1000000UL / APM_LINUX_IO_RATE);
         _num_io_procs++;
     } else {
         hal.console->printf("Out of IO processes\n");
@@ -220,10 +242,12 @@ void Scheduler::_timer_task()
     }
     _in_timer_proc = true;
 
+    const uint32_t start_us = AP_HAL::micros();
+
     // now call the timer based drivers
     for (i = 0; i < _num_timer_procs; i++) {
         if (_timer_proc[i]) {
-            _timer_proc[i]();
+            _run_timed(_timer_proc[i], _timer_proc_stats[i]);
         }
     }
 
@@ -232,9 +256,28 @@ void Scheduler::_timer_task()
         _failsafe();
     }
 
+    if (_timer_stats) {
+        _timer_stats->sample(AP_HAL::micros() - start_us);
+    }
+
     _in_timer_proc = false;
 }
 
+/*
+  run proc, recording how long it took if it has stats
+ */
+void Scheduler::_run_timed(AP_HAL::MemberProc proc, TimingStats *stats)
+{
+    if (stats == nullptr) {
+        proc();
+        return;
+    }
+
+    const uint32_t start_us = AP_HAL::micros();
+    proc();
+    stats->sample(AP_HAL::micros() - start_us);
+}
+
 void Scheduler::_run_io(void)
 {
     if (!_io_semaphore.take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
@@ -244,7 +287,7 @@ void Scheduler::_run_io(void)
     // now call the IO based drivers
     for (int i = 0; i < _num_io_procs; i++) {
         if (_io_proc[i]) {
-            _io_proc[i]();
+            _run_timed(_io_proc[i], _io_proc_stats[i]);
         }
     }
 
@@ -269,7 +312,13 @@ void Scheduler::_run_uarts()
 
 void Scheduler::_rcin_task()
 {
+    const uint32_t start_us = AP_HAL::micros();
+
     RCInput::from(hal.rcin)->_timer_tick();
+
+    if (_rcin_stats) {
+        _rcin_stats->sample(AP_HAL::micros() - start_us);
+    }
 }
 
 void Scheduler::_uart_task()
@@ -279,11 +328,17 @@ void Scheduler::_uart_task()
 
 void Scheduler::_io_task()
 {
+    const uint32_t start_us = AP_HAL::micros();
+
     // process any pending storage writes
     hal.storage->_timer_tick();
 
     // run registered IO processes
     _run_io();
+
+    if (_io_stats) {
+        _io_stats->sample(AP_HAL::micros() - start_us);
+    }
 }
 
 bool Scheduler::in_main_thread() const
@@ -330,6 +385,13 @@ bool Scheduler::SchedulerThread::_run()
     return PeriodicThread::_run();
 }
 
+bool Scheduler::SchedulerPollerThread::_run()
+{
+    _sched._wait_all_threads();
+
+    return PollerThread::_run();
+}
+
 void Scheduler::teardown()
 {
     _timer_thread.stop();
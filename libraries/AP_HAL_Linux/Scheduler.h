@@ -3,8 +3,10 @@
 #include <pthread.h>
 
 #include "AP_HAL_Linux.h"
+#include "PollerThread.h"
 #include "Semaphores.h"
 #include "Thread.h"
+#include "TimingStats.h"
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
@@ -51,6 +53,12 @@ public:
       create a new thread
      */
     bool thread_create(AP_HAL::MemberProc, const char *name, uint32_t stack_size, priority_base base, int8_t priority) override;
+
+    /*
+      poller of the UART thread, for UARTs to register their file
+      descriptors with
+     */
+    Poller &get_uart_poller() { return _uart_thread.get_poller(); }
     
 private:
     class SchedulerThread : public PeriodicThread {
@@ -66,6 +74,22 @@ private:
         Scheduler &_sched;
     };
 
+    /*
+      a thread that waits on file descriptors rather than running at
+      a fixed rate, with periodic work added as timers
+     */
+    class SchedulerPollerThread : public PollerThread {
+    public:
+        SchedulerPollerThread(Scheduler &sched)
+            : _sched(sched)
+        { }
+
+    protected:
+        bool _run() override;
+
+        Scheduler &_sched;
+    };
+
     void     init_realtime();
 
     void _wait_all_threads();
@@ -78,16 +102,23 @@ private:
     pthread_barrier_t _initialized_barrier;
 
     AP_HAL::MemberProc _timer_proc[LINUX_SCHEDULER_MAX_TIMER_PROCS];
+    TimingStats *_timer_proc_stats[LINUX_SCHEDULER_MAX_TIMER_PROCS];
     uint8_t _num_timer_procs;
     volatile bool _in_timer_proc;
 
     AP_HAL::MemberProc _io_proc[LINUX_SCHEDULER_MAX_IO_PROCS];
+    TimingStats *_io_proc_stats[LINUX_SCHEDULER_MAX_IO_PROCS];
     uint8_t _num_io_procs;
 
+    // execution time of each pass of the scheduler threads
+    TimingStats *_timer_stats;
+    TimingStats *_io_stats;
+    TimingStats *_rcin_stats;
+
     SchedulerThread _timer_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_timer_task, void), *this};
     SchedulerThread _io_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_io_task, void), *this};
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
-    SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
+    SchedulerPollerThread _uart_thread{*this};
 
     void _timer_task();
     void _io_task();
@@ -97,6 +128,8 @@ private:
     void _run_io();
     void _run_uarts();
 
+    static void _run_timed(AP_HAL::MemberProc proc, TimingStats *stats);
+
     uint64_t _stopped_clock_usec;
     uint64_t _last_stack_debug_msec;
     pthread_t _main_ctx;
@@ -23,4 +23,11 @@ public:
 
     /* Depends on lower level to implement, most devices are fine with defaults */
     virtual void set_parity(int v) { }
+
+    /*
+     * File descriptor to wait on for the device to become readable or
+     * writable, or -1 if it can only be polled on a timer. It can change
+     * as the device is opened, closed and connected.
+     */
+    virtual int get_fd() const { return -1; }
 };
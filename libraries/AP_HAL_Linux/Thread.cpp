@@ -18,6 +18,7 @@
 
 #include <alloca.h>
 #include <limits.h>
+#include <sched.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -287,4 +288,88 @@ bool PeriodicThread::stop()
     return true;
 }
 
+
+bool WorkerThread::start_pinned(const char *name, int cpu)
+{
+    struct sched_param param;
+    int policy;
+
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) {
+        return false;
+    }
+
+    _cpu = cpu;
+
+    return start(name, policy, param.sched_priority);
+}
+
+void WorkerThread::dispatch(task_t task)
+{
+    pthread_mutex_lock(&_mtx);
+    _task = task;
+    _pending = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mtx);
+}
+
+void WorkerThread::wait()
+{
+    pthread_mutex_lock(&_mtx);
+    while (_pending) {
+        pthread_cond_wait(&_cond, &_mtx);
+    }
+    pthread_mutex_unlock(&_mtx);
+}
+
+bool WorkerThread::_run()
+{
+    if (_cpu >= 0) {
+        cpu_set_t cpus;
+
+        CPU_ZERO(&cpus);
+        CPU_SET(_cpu, &cpus);
+        /* not fatal: the worker still runs, only without affinity */
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "WorkerThread: failed to pin to CPU %d\n", _cpu);
+        }
+    }
+
+    pthread_mutex_lock(&_mtx);
+    while (!_should_exit) {
+        if (!_pending) {
+            pthread_cond_wait(&_cond, &_mtx);
+            continue;
+        }
+
+        task_t task = _task;
+        pthread_mutex_unlock(&_mtx);
+
+        task();
+
+        pthread_mutex_lock(&_mtx);
+        _pending = false;
+        pthread_cond_broadcast(&_cond);
+    }
+    pthread_mutex_unlock(&_mtx);
+
+    _started = false;
+    _should_exit = false;
+
+    return true;
+}
+
+bool WorkerThread::stop()
+{
+    if (!is_started()) {
+        return false;
+    }
+
+    pthread_mutex_lock(&_mtx);
+    _should_exit = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mtx);
+
+    return true;
+}
+
 }
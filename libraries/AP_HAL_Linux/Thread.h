@@ -93,4 +93,41 @@ protected:
     uint64_t _period_usec = 0;
 };
 
+/*
+ * Thread that sleeps until its owner hands it a task, runs that task once
+ * and signals completion. This allows independent pieces of work that must
+ * finish within the same loop iteration to be spread over several CPUs.
+ */
+class WorkerThread : public Thread {
+public:
+    WorkerThread()
+        : Thread(nullptr)
+    { }
+
+    /*
+     * Start the thread, pinned to @cpu if it's not negative. The thread
+     * inherits the scheduling policy and priority of the caller.
+     */
+    bool start_pinned(const char *name, int cpu);
+
+    /*
+     * Hand @task to the worker. Must not be called again before the previous
+     * task has been waited for.
+     */
+    void dispatch(task_t task);
+
+    /* Block until the last dispatched task has completed */
+    void wait();
+
+    bool stop() override;
+
+protected:
+    bool _run() override;
+
+    pthread_mutex_t _mtx = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t _cond = PTHREAD_COND_INITIALIZER;
+    bool _pending = false;
+    int _cpu = -1;
+};
+
 }
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+
+#include "Semaphores.h"
+#include "TimingStats.h"
+
+using namespace Linux;
+
+TimingStats *TimingStats::_first;
+TimingStats *TimingStats::_last;
+
+static Semaphore list_sem;
+
+TimingStats::TimingStats(const char *name, uint32_t period_us) :
+    _period_us(period_us),
+    _count(0),
+    _min_us(0),
+    _max_us(0),
+    _overruns(0),
+    _sum_us(0),
+    _next(nullptr)
+{
+    strncpy(_name, name, sizeof(_name)-1);
+    _name[sizeof(_name)-1] = 0;
+    memset(_buckets, 0, sizeof(_buckets));
+}
+
+TimingStats *TimingStats::create(const char *name, uint32_t period_us)
+{
+    TimingStats *ts = new TimingStats(name, period_us);
+    if (ts == nullptr) {
+        return nullptr;
+    }
+
+    WITH_SEMAPHORE(list_sem);
+    if (_last == nullptr) {
+        _first = ts;
+    } else {
+        _last->_next = ts;
+    }
+    _last = ts;
+    return ts;
+}
+
+const TimingStats *TimingStats::get(uint8_t idx)
+{
+    WITH_SEMAPHORE(list_sem);
+    const TimingStats *ts = _first;
+    while (ts != nullptr && idx-- > 0) {
+        ts = ts->_next;
+    }
+    return ts;
+}
+
+/*
+  buckets 0 to 3 hold 0 to 3us, then each power of two is split in
+  four
+ */
+uint8_t TimingStats::bucket(uint32_t us)
+{
+    if (us < 4) {
+        return us;
+    }
+    const uint8_t e = 31 - __builtin_clz(us);
+    const uint32_t idx = 4U*(e-1) + ((us >> (e-2)) & 3U);
+    return MIN(idx, num_buckets-1U);
+}
+
+uint32_t TimingStats::bucket_max(uint8_t idx)
+{
+    if (idx < 4) {
+        return idx;
+    }
+    const uint8_t e = idx/4 + 1;
+    const uint32_t lower = (4U + idx%4) << (e-2);
+    return lower + (1U << (e-2)) - 1;
+}
+
+void TimingStats::sample(uint32_t elapsed_us)
+{
+    if (_count == 0 || elapsed_us < _min_us) {
+        _min_us = elapsed_us;
+    }
+    if (elapsed_us > _max_us) {
+        _max_us = elapsed_us;
+    }
+    if (_period_us != 0 && elapsed_us > _period_us) {
+        _overruns++;
+    }
+    _sum_us += elapsed_us;
+    _buckets[bucket(elapsed_us)]++;
+    _count++;
+}
+
+void TimingStats::get_stats(AP_HAL::Util::TimingStats &stats) const
+{
+    memcpy(stats.name, _name, sizeof(stats.name));
+    // the owning thread may be adding a sample as we read, which can
+    // only make these a sample out of step with each other
+    stats.count = _count;
+    stats.min_us = _min_us;
+    stats.max_us = _max_us;
+    stats.overruns = _overruns;
+    stats.mean_us = stats.count ? _sum_us / stats.count : 0;
+
+    stats.p99_us = 0;
+    uint32_t total = 0;
+    for (uint8_t i=0; i<num_buckets; i++) {
+        total += _buckets[i];
+    }
+    const uint64_t threshold = (uint64_t(total) * 99 + 99) / 100;
+    uint32_t sum = 0;
+    for (uint8_t i=0; i<num_buckets && total > 0; i++) {
+        sum += _buckets[i];
+        if (sum >= threshold) {
+            stats.p99_us = MIN(bucket_max(i), stats.max_us);
+            break;
+        }
+    }
+}
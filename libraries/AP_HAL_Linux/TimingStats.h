@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <AP_HAL/AP_HAL.h>
+
+namespace Linux {
+
+/*
+  execution time histogram of a HAL thread or of a callback run by
+  one. Samples only come from the thread that does the work, so they
+  take no lock and cost a clock read and a few adds. Entries live for
+  the life of the process, in a list that can be read from any thread.
+
+  The histogram has four buckets per power of two, which puts the
+  reported 99th percentile within 25% of the true value
+ */
+class TimingStats {
+public:
+    // create an entry and add it to the list. Returns nullptr if
+    // out of memory
+    static TimingStats *create(const char *name, uint32_t period_us);
+
+    // entry idx in creation order, or nullptr past the last one
+    static const TimingStats *get(uint8_t idx);
+
+    // record one run taking elapsed_us
+    void sample(uint32_t elapsed_us);
+
+    // a run longer than this counts as an overrun, zero for none
+    void set_period(uint32_t period_us) { _period_us = period_us; }
+
+    void get_stats(AP_HAL::Util::TimingStats &stats) const;
+
+private:
+    TimingStats(const char *name, uint32_t period_us);
+
+    static const uint8_t num_buckets = 80;  // up to about 2 seconds
+
+    static uint8_t bucket(uint32_t us);
+    static uint32_t bucket_max(uint8_t idx);
+
+    char _name[16];
+    uint32_t _period_us;
+    uint32_t _count;
+    uint32_t _min_us;
+    uint32_t _max_us;
+    uint32_t _overruns;
+    uint64_t _sum_us;
+    uint32_t _buckets[num_buckets];
+
+    TimingStats *_next;
+    static TimingStats *_first;
+    static TimingStats *_last;
+};
+
+}
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -20,6 +21,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "ConsoleDevice.h"
+#include "Scheduler.h"
 #include "TCPServerDevice.h"
 #include "UARTDevice.h"
 #include "UDPDevice.h"
@@ -218,6 +220,16 @@ void UARTDriver::end()
         hal.scheduler->delay(1);
     }
 
+    {
+        WITH_SEMAPHORE(_poll_sem);
+        if (_poll_events != 0) {
+            Scheduler::from(hal.scheduler)->get_uart_poller().unregister_pollable(&_pollable);
+            _poll_events = 0;
+        }
+        _pollable._fd = -1;
+        _poll_out = false;
+    }
+
     _device->close();
     _deallocate_buffers();
 }
@@ -310,6 +322,7 @@ size_t UARTDriver::write(uint8_t c)
     }
     size_t ret = _writebuf.write(&c, 1);
     _write_mutex.give();
+    _poll_kick();
     return ret;
 }
 
@@ -339,9 +352,40 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
 
     size_t ret = _writebuf.write(buffer, size);
     _write_mutex.give();
+    _poll_kick();
     return ret;
 }
 
+/*
+  reserve space for a whole packet in the write buffer. Blocking
+  writes go through write() so they keep their per-byte wait
+ */
+uint8_t UARTDriver::tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (!_initialised || !_nonblocking_writes) {
+        return 0;
+    }
+    if (!_write_mutex.take_nonblocking()) {
+        return 0;
+    }
+    if (_writebuf.space() < len) {
+        _write_mutex.give();
+        return 0;
+    }
+    const uint8_t n_vec = _writebuf.reserve(vec, len);
+    if (n_vec == 0) {
+        _write_mutex.give();
+    }
+    return n_vec;
+}
+
+void UARTDriver::tx_commit(uint32_t len)
+{
+    _writebuf.commit(len);
+    _write_mutex.give();
+    _poll_kick();
+}
+
 /*
   try writing n bytes, handling an unresponsive port
  */
@@ -417,23 +461,13 @@ bool UARTDriver::_write_pending_bytes(void)
 }
 
 /*
-  push any pending bytes to/from the serial port. This is called at
-  1kHz in the timer thread. Doing it this way reduces the system call
-  overhead in the main task enormously.
+  try to fill the read buffer
+  return true if any bytes were read
  */
-void UARTDriver::_timer_tick(void)
+bool UARTDriver::_read_pending_bytes(void)
 {
-    if (!_initialised) return;
-
-    _in_timer = true;
-
-    uint8_t num_send = 10;
-    while (num_send != 0 && _write_pending_bytes()) {
-        num_send--;
-    }
-
-    // try to fill the read buffer
     int ret;
+    bool progress = false;
     ByteBuffer::IoVec vec[2];
 
     const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
@@ -443,6 +477,7 @@ void UARTDriver::_timer_tick(void)
             break;
         }
         _readbuf.commit((unsigned)ret);
+        progress |= ret > 0;
 
         // update receive timestamp
         _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
@@ -454,9 +489,181 @@ void UARTDriver::_timer_tick(void)
         }
     }
 
+    return progress;
+}
+
+/*
+  push any pending bytes to/from the serial port. This is called at
+  the UART thread's rate as well as when the device is ready. Doing
+  it this way reduces the system call overhead in the main task
+  enormously.
+ */
+void UARTDriver::_timer_tick(void)
+{
+    if (!_initialised) return;
+
+    _in_timer = true;
+
+    uint8_t num_send = 10;
+    while (num_send != 0 && _write_pending_bytes()) {
+        num_send--;
+    }
+
+    _read_pending_bytes();
+
+    {
+        WITH_SEMAPHORE(_poll_sem);
+        _write_stalled = false;
+        _poll_update(true);
+    }
+
     _in_timer = false;
 }
 
+/*
+  bring the events the device's file descriptor is registered for
+  into line with the buffers. With sync_fd the registration also
+  follows the device's file descriptor, which may only be looked at
+  from the UART thread. Called with _poll_sem held
+ */
+void UARTDriver::_poll_update(bool sync_fd)
+{
+    Poller &poller = Scheduler::from(hal.scheduler)->get_uart_poller();
+
+    if (sync_fd) {
+        int fd = _device->get_fd();
+        if (fd != _poll_dead_fd || AP_HAL::millis() - _poll_dead_ms > 1000) {
+            _poll_dead_fd = -1;
+        } else {
+            fd = -1;
+        }
+        if (fd != _pollable.get_fd()) {
+            if (_poll_events != 0) {
+                // fails harmlessly if the old descriptor is already closed
+                poller.unregister_pollable(&_pollable);
+                _poll_events = 0;
+            }
+            _pollable._fd = fd;
+            _poll_fd_changed = true;
+        }
+    }
+    if (_pollable.get_fd() == -1) {
+        _poll_out = false;
+        return;
+    }
+
+    uint32_t events = 0;
+    if (_readbuf.space() > 0) {
+        events |= EPOLLIN;
+    }
+    // clear _poll_out before looking at the write buffer, so a writer
+    // that adds bytes after we look is sure to see it clear
+    _poll_out = false;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (_writebuf.available() > 0 && !_write_stalled) {
+        events |= EPOLLOUT;
+        _poll_out = true;
+    }
+
+    if (events == _poll_events) {
+        return;
+    }
+    bool ok;
+    if (events == 0) {
+        poller.unregister_pollable(&_pollable);
+        ok = true;
+    } else if (_poll_events == 0) {
+        ok = poller.register_pollable(&_pollable, events);
+    } else {
+        ok = poller.modify_pollable(&_pollable, events);
+    }
+    if (!ok) {
+        // leave it to the tick
+        poller.unregister_pollable(&_pollable);
+        _poll_out = false;
+        events = 0;
+    }
+    _poll_events = events;
+}
+
+/*
+  called after bytes are added to the write buffer, to have the UART
+  thread wake when the device can take them
+ */
+void UARTDriver::_poll_kick(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (_poll_out || _pollable.get_fd() == -1) {
+        return;
+    }
+    WITH_SEMAPHORE(_poll_sem);
+    _poll_update(false);
+}
+
+void UARTDriver::DevicePollable::on_can_read()
+{
+    if (!_uart._initialised) {
+        return;
+    }
+    _uart._in_timer = true;
+    _uart._poll_fd_changed = false;
+    _uart._read_pending_bytes();
+    {
+        WITH_SEMAPHORE(_uart._poll_sem);
+        _uart._poll_update(true);
+    }
+    _uart._in_timer = false;
+}
+
+void UARTDriver::DevicePollable::on_can_write()
+{
+    if (!_uart._initialised) {
+        return;
+    }
+    _uart._in_timer = true;
+    _uart._poll_fd_changed = false;
+    bool progress = false;
+    uint8_t num_send = 10;
+    while (num_send != 0 && _uart._write_pending_bytes()) {
+        progress = true;
+        num_send--;
+    }
+    {
+        WITH_SEMAPHORE(_uart._poll_sem);
+        if (!progress) {
+            // writable, but the device would not take anything, so
+            // don't spin on it until the next tick
+            _uart._write_stalled = true;
+        }
+        _uart._poll_update(true);
+    }
+    _uart._in_timer = false;
+}
+
+/*
+  the device reported an error or hang up. These are level triggered
+  and reported on every poll, so stop waiting on this descriptor and
+  leave the device to the tick until it gets a new one, or for a
+  second. If the read handler already moved us to a new descriptor
+  the hang up was for the old one
+ */
+void UARTDriver::DevicePollable::on_hang_up()
+{
+    WITH_SEMAPHORE(_uart._poll_sem);
+    if (_uart._poll_fd_changed) {
+        _uart._poll_fd_changed = false;
+        return;
+    }
+    if (_uart._poll_events != 0) {
+        Scheduler::from(hal.scheduler)->get_uart_poller().unregister_pollable(this);
+        _uart._poll_events = 0;
+    }
+    _uart._poll_dead_fd = _fd;
+    _uart._poll_dead_ms = AP_HAL::millis();
+    _fd = -1;
+    _uart._poll_out = false;
+}
+
 void UARTDriver::configure_parity(uint8_t v) {
     _device->set_parity(v);
 }
@@ -2,8 +2,10 @@
 
 #include <AP_HAL/utility/OwnPtr.h>
 #include <AP_HAL/utility/RingBuffer.h>
+#include <AP_HAL/utility/SPSCByteBuffer.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "SerialDevice.h"
 #include "Semaphores.h"
 
@@ -29,6 +31,9 @@ public:
     /* Linux implementations of Stream virtual methods */
     uint32_t available() override;
     uint32_t txspace() override;
+
+    uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    void tx_commit(uint32_t len) override;
     int16_t read() override;
 
     /* Linux implementations of Print virtual methods */
@@ -88,14 +93,51 @@ private:
     uint64_t _receive_timestamp[2];
     uint8_t _receive_timestamp_idx;
 
+    /*
+      the device's file descriptor is registered with the UART
+      thread's poller, so reads and writes happen when the device is
+      ready rather than on the thread's tick. The tick still runs to
+      handle devices without a file descriptor and reconnections
+     */
+    class DevicePollable : public Pollable {
+        friend class UARTDriver;
+    public:
+        DevicePollable(UARTDriver &uart) : _uart(uart) { }
+
+        // the file descriptor belongs to the device, don't close it
+        ~DevicePollable() { _fd = -1; }
+
+        void on_can_read() override;
+        void on_can_write() override;
+        void on_error() override { on_hang_up(); }
+        void on_hang_up() override;
+
+    private:
+        UARTDriver &_uart;
+    };
+
+    DevicePollable _pollable{*this};
+    Linux::Semaphore _poll_sem;
+    uint32_t _poll_events;      // events registered for, zero if not registered
+    volatile bool _poll_out;    // waiting for the device to be writable
+    bool _write_stalled;        // a write made no progress, leave it to the tick
+    bool _poll_fd_changed;      // registration moved to a new fd since the last hang up
+    int _poll_dead_fd = -1;     // fd that hung up, not to be registered for a while
+    uint32_t _poll_dead_ms;
+
+    bool _read_pending_bytes(void);
+    void _poll_update(bool sync_fd);
+    void _poll_kick(void);
+
 protected:
     const char *device_path;
     volatile bool _initialised;
 
     // we use in-task ring buffers to reduce the system call cost
-    // of ::read() and ::write() in the main loop
-    ByteBuffer _readbuf{0};
-    ByteBuffer _writebuf{0};
+    // of ::read() and ::write() in the main loop. Each has one
+    // writer thread and one reader thread, so needs no lock
+    SPSCByteBuffer _readbuf{0};
+    SPSCByteBuffer _writebuf{0};
 
     virtual int _write_fd(const uint8_t *buf, uint16_t n);
     virtual int _read_fd(uint8_t *buf, uint16_t n);
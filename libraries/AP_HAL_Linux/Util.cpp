@@ -10,6 +10,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "Heat_Pwm.h"
+#include "TimingStats.h"
 #include "ToneAlarm_Disco.h"
 #include "Util.h"
 
@@ -145,6 +146,16 @@ bool Util::get_system_id(char buf[40])
     return get_system_id_unformatted((uint8_t *)buf, len);
 }
 
+bool Util::get_timing_stats(uint8_t idx, TimingStats &stats)
+{
+    const Linux::TimingStats *ts = Linux::TimingStats::get(idx);
+    if (ts == nullptr) {
+        return false;
+    }
+    ts->get_stats(stats);
+    return true;
+}
+
 
 int Util::write_file(const char *path, const char *fmt, ...)
 {
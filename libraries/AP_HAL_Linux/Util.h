@@ -99,6 +99,8 @@ public:
         return Perf::get_singleton()->count(perf);
     }
 
+    bool get_timing_stats(uint8_t idx, TimingStats &stats) override;
+
     int get_hw_arm32();
 
     bool toneAlarm_init() override { return _toneAlarm.init(); }
@@ -2,6 +2,7 @@
 
 namespace HALSITL {
 class UARTDriver;
+class FleetBus;
 class Scheduler;
 class SITL_State;
 class Storage;
@@ -0,0 +1,137 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  shared memory packet bus between SITL vehicles
+ */
+#include <AP_HAL/AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "FleetBus.h"
+
+#include <AP_Math/AP_Math.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace HALSITL;
+
+FleetBus *FleetBus::attach(const char *name)
+{
+    char shm_name[64];
+    snprintf(shm_name, sizeof(shm_name), "/ardupilot-fleet-%s", name);
+
+    int fd = shm_open(shm_name, O_RDWR|O_CREAT, 0600);
+    if (fd == -1) {
+        AP_HAL::panic("fleet bus %s open failed: %s", shm_name, strerror(errno));
+    }
+    // all users size the object the same way, so whoever gets here
+    // first creates it zero filled and the rest are no-ops
+    if (ftruncate(fd, sizeof(struct shared)) == -1) {
+        AP_HAL::panic("fleet bus %s resize failed: %s", shm_name, strerror(errno));
+    }
+    void *p = mmap(nullptr, sizeof(struct shared), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        AP_HAL::panic("fleet bus %s map failed: %s", shm_name, strerror(errno));
+    }
+
+    struct shared *bus = (struct shared *)p;
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&bus->magic, &expected, magic, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+        expected != magic) {
+        AP_HAL::panic("fleet bus %s has a different layout; remove /dev/shm%s", shm_name, shm_name);
+    }
+
+    ::printf("Attached to fleet bus %s\n", name);
+    return new FleetBus(bus);
+}
+
+uint32_t FleetBus::head(void) const
+{
+    return __atomic_load_n(&bus->head, __ATOMIC_ACQUIRE);
+}
+
+void FleetBus::send(uint32_t sender, const uint8_t *buf, uint16_t len)
+{
+    if (len > slot_size) {
+        // not a packet we know how to frame, drop it as a network would
+        return;
+    }
+    const uint32_t seq = __atomic_fetch_add(&bus->head, 1, __ATOMIC_ACQ_REL);
+    struct slot &s = bus->slots[seq % num_slots];
+
+    __atomic_store_n(&s.seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s.sender = sender;
+    s.len = len;
+    memcpy(s.data, buf, len);
+    __atomic_store_n(&s.seq, seq+1, __ATOMIC_RELEASE);
+}
+
+uint16_t FleetBus::receive(uint32_t self, uint32_t &read_seq, uint8_t *buf, uint16_t buflen)
+{
+    uint8_t tmp[slot_size];
+
+    while (true) {
+        const uint32_t h = head();
+        if (read_seq == h) {
+            return 0;
+        }
+        if (h - read_seq > num_slots) {
+            // we have been lapped, skip to the oldest packet still held
+            read_seq = h - num_slots;
+        }
+
+        const struct slot &s = bus->slots[read_seq % num_slots];
+        const uint32_t seq1 = __atomic_load_n(&s.seq, __ATOMIC_ACQUIRE);
+        if (seq1 != read_seq+1) {
+            if (seq1 == 0 || int32_t(seq1 - (read_seq+1)) < 0) {
+                // the writer has not finished with this slot yet
+                return 0;
+            }
+            // overwritten by a later packet
+            read_seq++;
+            continue;
+        }
+
+        const uint32_t sender = s.sender;
+        const uint16_t len = MIN(s.len, slot_size);
+        memcpy(tmp, s.data, len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s.seq, __ATOMIC_RELAXED) != seq1) {
+            // overwritten while we copied it
+            read_seq++;
+            continue;
+        }
+
+        if (sender == self) {
+            read_seq++;
+            continue;
+        }
+        if (len > buflen) {
+            return 0;
+        }
+        memcpy(buf, tmp, len);
+        read_seq++;
+        return len;
+    }
+}
+
+#endif // CONFIG_HAL_BOARD
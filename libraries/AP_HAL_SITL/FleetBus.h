@@ -0,0 +1,62 @@
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include <stdint.h>
+#include "AP_HAL_SITL_Namespace.h"
+
+/*
+  an in-memory broadcast channel between SITL vehicles on the same
+  host.
+
+  The bus is a ring of packet slots in a named POSIX shared memory
+  object, so every SITL process that attaches to the same name sees
+  the packets of all the others without going through the network
+  stack. Each slot is guarded by a sequence number (a seqlock), so
+  writers never wait for readers. Like UDP the bus is lossy: a reader
+  that falls more than a ring behind skips to the oldest packet still
+  held.
+ */
+class HALSITL::FleetBus {
+public:
+    // attach to the named bus, creating it if this is the first user
+    static FleetBus *attach(const char *name);
+
+    // the sequence number a new reader should start at
+    uint32_t head(void) const;
+
+    // broadcast one packet to every other process on the bus
+    void send(uint32_t sender, const uint8_t *buf, uint16_t len);
+
+    /*
+      fetch the next packet from another process, advancing read_seq
+      past it. Returns the packet length, or zero if there is nothing
+      new or the next packet does not fit in buflen
+     */
+    uint16_t receive(uint32_t self, uint32_t &read_seq, uint8_t *buf, uint16_t buflen);
+
+private:
+    static const uint32_t magic = 0x464c4545; // FLEE
+    static const uint16_t num_slots = 1024;
+    static const uint16_t slot_size = 300;    // a signed MAVLink2 packet is 280 bytes
+
+    struct slot {
+        uint32_t seq;       // sequence number plus one once written, zero while being written
+        uint32_t sender;
+        uint16_t len;
+        uint8_t data[slot_size];
+    };
+
+    struct shared {
+        uint32_t magic;
+        uint32_t head;
+        struct slot slots[num_slots];
+    };
+
+    FleetBus(struct shared *_bus) : bus(_bus) {}
+
+    struct shared *bus;
+};
+
+#endif // CONFIG_HAL_BOARD
@@ -105,6 +105,9 @@ private:
     void _parse_command_line(int argc, char * const argv[]);
     void _set_param_default(const char *parm);
     void _usage(void);
+    void _start_fleet(int argc, char * const argv[]);
+    void _fleet_set_defaults(void);
+    char *_fleet_path(const char *path) const;
     void _sitl_setup(const char *home_str);
     void _setup_fdm(void);
     void _setup_timer(void);
@@ -268,6 +271,11 @@ private:
     const char *defaults_path = HAL_PARAM_DEFAULTS_PATH;
 
     const char *_home_str;
+
+    // index of this vehicle within a --fleet launch, and the
+    // directory the fleet was launched from (nullptr if not a fleet)
+    uint8_t _fleet_member = 0;
+    const char *_fleet_dir = nullptr;
 };
 
 #endif // CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -34,8 +34,16 @@
 #include <SITL/SIM_Scrimmage.h>
 #include <SITL/SIM_Webots.h>
 
+#include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdio.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
 
 extern const AP_HAL::HAL& hal;
 
@@ -50,6 +58,20 @@ static void _sig_fpe(int signum)
     abort();
 }
 
+// members of a --fleet launch, for the launching process to pass
+// signals on to
+static pid_t *fleet_members;
+static unsigned fleet_count;
+
+static void _sig_fleet(int signum)
+{
+    for (unsigned i=0; i<fleet_count; i++) {
+        if (fleet_members[i] > 0) {
+            kill(fleet_members[i], signum);
+        }
+    }
+}
+
 // catch segfault
 static void _sig_segv(int signum)
 {
@@ -70,6 +92,8 @@ void SITL_State::_usage(void)
            "\t--instance|-I N          set instance of SITL (adds 10*instance to all port numbers)\n"
            // "\t--param|-P NAME=VALUE    set some param\n"  CURRENTLY BROKEN!
            "\t--synthetic-clock|-S     set synthetic clock mode\n"
+           "\t--lockstep               run the simulation as fast as possible, ignoring speedup\n"
+           "\t--fleet N                run N vehicles, each in fleet/<n> as instance I+n\n"
            "\t--home|-O HOME           set start location (lat,lng,alt,yaw)\n"
            "\t--model|-M MODEL         set simulation model\n"
            "\t--config string          set additional simulation config string\n"
@@ -161,10 +185,164 @@ void SITL_State::_set_signal_handlers(void) const
 
 }
 
+/*
+  split a --fleet launch into one process per vehicle. The launching
+  process forks the members, passes termination signals on to them
+  and reaps them. On Linux members are also sent SIGTERM if the
+  launching process dies without passing a signal on. Each member
+  runs in its own fleet/<n> directory so eeprom, logs and terrain stay
+  separate, and finds its index in the environment again after a
+  reboot instead of forking a new fleet
+ */
+void SITL_State::_start_fleet(int argc, char * const argv[])
+{
+    const char *member = getenv("SITL_FLEET_MEMBER");
+    if (member == nullptr) {
+        unsigned count = 0;
+        for (int i=1; i<argc; i++) {
+            if (strcmp(argv[i], "--fleet") == 0 && i+1 < argc) {
+                count = atoi(argv[i+1]);
+            } else if (strncmp(argv[i], "--fleet=", 8) == 0) {
+                count = atoi(&argv[i][8]);
+            }
+        }
+        if (count == 0) {
+            return;
+        }
+        if (count > 200) {
+            printf("Fleet of %u vehicles is too large\n", count);
+            exit(1);
+        }
+
+        char cwd[PATH_MAX];
+        if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+            AP_HAL::panic("getcwd failed: %s", strerror(errno));
+        }
+        setenv("SITL_FLEET_DIR", cwd, 1);
+        mkdir("fleet", 0755);
+
+        const pid_t launcher = getpid();
+        fleet_members = new pid_t[count];
+        for (unsigned i=0; i<count && member == nullptr; i++) {
+            fleet_members[i] = fork();
+            if (fleet_members[i] == -1) {
+                AP_HAL::panic("fork failed: %s", strerror(errno));
+            }
+            fleet_count = i+1;
+            if (fleet_members[i] == 0) {
+#if defined(__linux__)
+                prctl(PR_SET_PDEATHSIG, SIGTERM);
+                if (getppid() != launcher) {
+                    // launcher died before the death signal was set
+                    exit(1);
+                }
+#else
+                (void)launcher;
+#endif
+                delete[] fleet_members;
+                fleet_members = nullptr;
+                fleet_count = 0;
+                char index[4];
+                snprintf(index, sizeof(index), "%u", i);
+                setenv("SITL_FLEET_MEMBER", index, 1);
+                member = getenv("SITL_FLEET_MEMBER");
+            }
+        }
+        if (member == nullptr) {
+            printf("Started fleet of %u vehicles\n", count);
+            struct sigaction sa_fleet = {};
+            sigemptyset(&sa_fleet.sa_mask);
+            sa_fleet.sa_handler = _sig_fleet;
+            sigaction(SIGINT, &sa_fleet, nullptr);
+            sigaction(SIGTERM, &sa_fleet, nullptr);
+            sigaction(SIGHUP, &sa_fleet, nullptr);
+            for (unsigned i=0; i<count; i++) {
+                int status;
+                while (waitpid(fleet_members[i], &status, 0) == -1 && errno == EINTR) {
+                }
+            }
+            exit(0);
+        }
+    }
+
+    _fleet_member = atoi(member);
+    _fleet_dir = getenv("SITL_FLEET_DIR");
+    if (_fleet_dir == nullptr) {
+        AP_HAL::panic("SITL_FLEET_DIR not set");
+    }
+    char *dir = nullptr;
+    if (asprintf(&dir, "%s/fleet/%u", _fleet_dir, (unsigned)_fleet_member) <= 0) {
+        AP_HAL::panic("out of memory");
+    }
+    mkdir(dir, 0755);
+    if (chdir(dir) != 0) {
+        AP_HAL::panic("chdir(%s) failed: %s", dir, strerror(errno));
+    }
+    free(dir);
+}
+
+/*
+  give a fleet member its own MAVLink system ID. This is done with a
+  defaults file written to the member directory and added after any
+  --defaults files, so it survives the eeprom being erased on first
+  start, and a SYSID_THISMAV set by the user still takes precedence
+ */
+void SITL_State::_fleet_set_defaults(void)
+{
+    char *path = nullptr;
+    if (asprintf(&path, "%s/fleet/%u/fleet.parm", _fleet_dir, (unsigned)_fleet_member) <= 0) {
+        AP_HAL::panic("out of memory");
+    }
+    FILE *f = fopen(path, "w");
+    if (f == nullptr) {
+        AP_HAL::panic("failed to create %s: %s", path, strerror(errno));
+    }
+    fprintf(f, "SYSID_THISMAV %u\n", (unsigned)_instance+1);
+    fclose(f);
+
+    if (defaults_path != nullptr) {
+        char *joined = nullptr;
+        if (asprintf(&joined, "%s,%s", defaults_path, path) <= 0) {
+            AP_HAL::panic("out of memory");
+        }
+        free(path);
+        path = joined;
+    }
+    defaults_path = path;
+}
+
+/*
+  make a comma separated list of paths given on the command line
+  usable from inside a fleet member directory
+ */
+char *SITL_State::_fleet_path(const char *path) const
+{
+    if (_fleet_dir == nullptr) {
+        return strdup(path);
+    }
+    char *ret = strdup("");
+    char *saveptr = nullptr;
+    char *s = strdup(path);
+    for (char *p = strtok_r(s, ",", &saveptr); p; p = strtok_r(nullptr, ",", &saveptr)) {
+        const bool absolute = (p[0] == '/');
+        char *joined = nullptr;
+        if (asprintf(&joined, "%s%s%s%s%s", ret, *ret?",":"",
+                     absolute?"":_fleet_dir, absolute?"":"/", p) <= 0) {
+            AP_HAL::panic("out of memory");
+        }
+        free(ret);
+        ret = joined;
+    }
+    free(s);
+    return ret;
+}
+
 void SITL_State::_parse_command_line(int argc, char * const argv[])
 {
     int opt;
     float speedup = 1.0f;
+    bool lockstep = false;
+    bool instance_given = false;
     _instance = 0;
     _synthetic_clock_mode = false;
     // default to CMAC
@@ -210,6 +388,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_SIM_PORT_IN,
         CMDLINE_SIM_PORT_OUT,
         CMDLINE_IRLOCK_PORT,
+        CMDLINE_LOCKSTEP,
+        CMDLINE_FLEET,
     };
 
     const struct GetOptLong::option options[] = {
@@ -245,6 +425,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"sim-port-in",     true,   0, CMDLINE_SIM_PORT_IN},
         {"sim-port-out",    true,   0, CMDLINE_SIM_PORT_OUT},
         {"irlock-port",     true,   0, CMDLINE_IRLOCK_PORT},
+        {"lockstep",        false,  0, CMDLINE_LOCKSTEP},
+        {"fleet",           true,   0, CMDLINE_FLEET},
         {0, false, 0, 0}
     };
 
@@ -256,6 +438,32 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     setvbuf(stdout, (char *)0, _IONBF, 0);
     setvbuf(stderr, (char *)0, _IONBF, 0);
 
+    // this must happen before any option touches the eeprom
+    _start_fleet(argc, argv);
+
+    // offset all port numbers by 10 per instance
+    auto set_instance = [&](uint8_t instance) {
+        _instance = instance;
+        if (_base_port == BASE_PORT) {
+            _base_port += _instance * 10;
+        }
+        if (_rcin_port == RCIN_PORT) {
+            _rcin_port += _instance * 10;
+        }
+        if (_fg_view_port == FG_VIEW_PORT) {
+            _fg_view_port += _instance * 10;
+        }
+        if (simulator_port_in == SIM_IN_PORT) {
+            simulator_port_in += _instance * 10;
+        }
+        if (simulator_port_out == SIM_OUT_PORT) {
+            simulator_port_out += _instance * 10;
+        }
+        if (_irlock_port == IRLOCK_PORT) {
+            _irlock_port += _instance * 10;
+        }
+    };
+
     GetOptLong gopt(argc, argv, "hwus:r:CI:P:SO:M:F:c:",
                     options);
 
@@ -280,28 +488,10 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case 'C':
             HALSITL::UARTDriver::_console = true;
             break;
-        case 'I': {
-            _instance = atoi(gopt.optarg);
-            if (_base_port == BASE_PORT) {
-                _base_port += _instance * 10;
-            }
-            if (_rcin_port == RCIN_PORT) {
-                _rcin_port += _instance * 10;
-            }
-            if (_fg_view_port == FG_VIEW_PORT) {
-                _fg_view_port += _instance * 10;
-            }
-            if (simulator_port_in == SIM_IN_PORT) {
-                simulator_port_in += _instance * 10;
-            }
-            if (simulator_port_out == SIM_OUT_PORT) {
-                simulator_port_out += _instance * 10;
-            }
-            if (_irlock_port == IRLOCK_PORT) {
-                _irlock_port += _instance * 10;
-            }
-        }
-        break;
+        case 'I':
+            set_instance(atoi(gopt.optarg) + _fleet_member);
+            instance_given = true;
+            break;
         case 'P':
             _set_param_default(gopt.optarg);
             break;
@@ -327,10 +517,10 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             _use_fg_view = false;
             break;
         case CMDLINE_AUTOTESTDIR:
-            autotest_dir = strdup(gopt.optarg);
+            autotest_dir = _fleet_path(gopt.optarg);
             break;
         case CMDLINE_DEFAULTS:
-            defaults_path = strdup(gopt.optarg);
+            defaults_path = _fleet_path(gopt.optarg);
             break;
         case CMDLINE_UARTA:
         case CMDLINE_UARTB:
@@ -363,12 +553,25 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_IRLOCK_PORT:
             _irlock_port = atoi(gopt.optarg);
             break;
+        case CMDLINE_LOCKSTEP:
+            lockstep = true;
+            break;
+        case CMDLINE_FLEET:
+            // handled by _start_fleet()
+            break;
         default:
             _usage();
             exit(1);
         }
     }
 
+    if (!instance_given && _fleet_member != 0) {
+        set_instance(_fleet_member);
+    }
+    if (_fleet_dir != nullptr) {
+        _fleet_set_defaults();
+    }
+
     if (!model_str) {
         printf("You must specify a vehicle model\n");
         exit(1);
@@ -389,6 +592,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             }
             sitl_model->set_interface_ports(simulator_address, simulator_port_in, simulator_port_out);
             sitl_model->set_speedup(speedup);
+            sitl_model->set_lockstep(lockstep);
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
             sitl_model->set_config(config);
@@ -39,7 +39,9 @@
 
 #include "UARTDriver.h"
 #include "SITL_State.h"
+#include "FleetBus.h"
 #include <AP_HAL/utility/packetise.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -79,6 +81,8 @@ void UARTDriver::begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace)
              udpclient:127.0.0.1:14550
              mcast:
              mcast:239.255.145.50:14550
+             fleet:           // in-memory bus to other SITL vehicles
+             fleet:swarm1     // named in-memory bus
              uart:/dev/ttyUSB0:57600
              sim:ParticleSensor_SDS021:
          */
@@ -126,6 +130,12 @@ void UARTDriver::begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace)
                 ::printf("UDP multicast connection %s:%u\n", ip, port);
                 _udp_start_multicast(ip, port);
             }
+        } else if (strcmp(devtype, "fleet") == 0) {
+            // shared memory bus to the other vehicles on this host
+            const char *name = args1 && *args1?args1:"default";
+            if (!_connected) {
+                _fleet_start(name);
+            }
         } else {
             AP_HAL::panic("Invalid device path: %s", path);
         }
@@ -224,6 +234,23 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
 }
 
     
+/*
+  reserve space for a whole packet in the write buffer. Unbuffered
+  writes go straight to the file descriptor, so use write() for those
+ */
+uint8_t UARTDriver::tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (_unbuffered_writes || txspace() < len) {
+        return 0;
+    }
+    return _writebuffer.reserve(vec, len);
+}
+
+void UARTDriver::tx_commit(uint32_t len)
+{
+    _writebuffer.commit(len);
+}
+
 /*
   start a TCP connection for the serial port. If wait_for_connection
   is true then block until a client connects
@@ -614,6 +641,43 @@ bool UARTDriver::set_unbuffered_writes(bool on) {
     return _unbuffered_writes;
 }
 
+/*
+  start a connection to an in-memory fleet bus
+ */
+void UARTDriver::_fleet_start(const char *name)
+{
+    _fleet_bus = FleetBus::attach(name);
+    // only see packets sent after we joined
+    _fleet_seq = _fleet_bus->head();
+    _packetise = true;
+    _connected = true;
+}
+
+/*
+  check that a packet from another vehicle on the fleet bus doesn't
+  carry our own MAVLink system ID, which would mean two vehicles can't
+  be told apart. Each bus packet is a single MAVLink packet as
+  sending is packetised
+ */
+void UARTDriver::_fleet_check_sysid(const uint8_t *pkt, uint16_t len)
+{
+    if (_fleet_sysid_clash) {
+        return;
+    }
+    uint8_t sysid;
+    if (pkt[0] == MAVLINK_STX_MAVLINK1 && len >= 8) {
+        sysid = pkt[3];
+    } else if (pkt[0] == MAVLINK_STX && len >= 12) {
+        sysid = pkt[5];
+    } else {
+        return;
+    }
+    if (sysid == mavlink_system.sysid) {
+        _fleet_sysid_clash = true;
+        ::printf("Fleet bus: another vehicle is also using MAVLink system ID %u\n", (unsigned)sysid);
+    }
+}
+
 void UARTDriver::_check_reconnect(void)
 {
     if (!_uart_path) {
@@ -652,7 +716,13 @@ void UARTDriver::_timer_tick(void)
             // keep as a single UDP packet
             uint8_t tmpbuf[n];
             _writebuffer.peekbytes(tmpbuf, n);
-            ssize_t ret = send(_fd, tmpbuf, n, MSG_DONTWAIT);
+            ssize_t ret;
+            if (_fleet_bus != nullptr) {
+                _fleet_bus->send(getpid(), tmpbuf, n);
+                ret = n;
+            } else {
+                ret = send(_fd, tmpbuf, n, MSG_DONTWAIT);
+            }
             if (ret > 0) {
                 _writebuffer.advance(ret);
             }
@@ -694,7 +764,16 @@ void UARTDriver::_timer_tick(void)
     
     char buf[space];
     ssize_t nread = 0;
-    if (_mc_fd >= 0) {
+    if (_fleet_bus != nullptr) {
+        // take whole packets while they fit
+        uint32_t n = 0;
+        uint16_t len;
+        while ((len = _fleet_bus->receive(getpid(), _fleet_seq, (uint8_t *)&buf[n], MIN(space - n, UINT16_MAX))) > 0) {
+            _fleet_check_sysid((const uint8_t *)&buf[n], len);
+            n += len;
+        }
+        nread = n;
+    } else if (_mc_fd >= 0) {
         if (_select_check(_mc_fd)) {
             struct sockaddr_in from;
             socklen_t fromlen = sizeof(from);
@@ -8,6 +8,7 @@
 #include "AP_HAL_SITL_Namespace.h"
 #include <AP_HAL/utility/Socket.h>
 #include <AP_HAL/utility/RingBuffer.h>
+#include <AP_HAL/utility/SPSCByteBuffer.h>
 
 class HALSITL::UARTDriver : public AP_HAL::UARTDriver {
 public:
@@ -20,6 +21,8 @@ public:
         _fd = -1;
         _mc_fd = -1;
         _listen_fd = -1;
+        _fleet_bus = nullptr;
+        _fleet_sysid_clash = false;
     }
 
     /* Implementations of UARTDriver virtual methods */
@@ -51,6 +54,9 @@ public:
     size_t write(uint8_t c) override;
     size_t write(const uint8_t *buffer, size_t size) override;
 
+    uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    void tx_commit(uint32_t len) override;
+
     // file descriptor, exposed so SITL_State::loop_hook() can use it
     int _fd;
 
@@ -90,8 +96,8 @@ private:
     int _serial_port;
     static bool _console;
     bool _nonblocking_writes;
-    ByteBuffer _readbuffer{16384};
-    ByteBuffer _writebuffer{16384};
+    SPSCByteBuffer _readbuffer{16384};
+    SPSCByteBuffer _writebuffer{16384};
 
     // default multicast IP and port
     const char *mcast_ip_default = "239.255.145.50";
@@ -109,6 +115,8 @@ private:
     void _tcp_start_client(const char *address, uint16_t port);
     void _udp_start_client(const char *address, uint16_t port);
     void _udp_start_multicast(const char *address, uint16_t port);
+    void _fleet_start(const char *name);
+    void _fleet_check_sysid(const uint8_t *pkt, uint16_t len);
     void _check_connection(void);
     static bool _select_check(int );
     static void _set_nonblocking(int );
@@ -121,6 +129,11 @@ private:
     uint16_t _mc_myport;
     uint32_t last_tick_us;
 
+    // in-memory bus to other SITL vehicles, see FleetBus.h
+    FleetBus *_fleet_bus;
+    uint32_t _fleet_seq;
+    bool _fleet_sysid_clash;
+
     // if this is not -1 then data should be written here instead of
     // _fd.  This is to support simulated serial devices, which use a
     // pipe for read and a pipe for write
@@ -800,7 +800,7 @@ void AP_Logger::WriteV(const char *name, const char *labels, const char *units,
         }
         va_list arg_copy;
         va_copy(arg_copy, arg_list);
-        backends[i]->Write(f->msg_type, arg_copy, is_critical);
+        backends[i]->Write(f, arg_copy, is_critical);
         va_end(arg_copy);
     }
 }
@@ -853,10 +853,24 @@ void AP_Logger::assert_same_fmt_for_name(const AP_Logger::log_write_fmt *f,
 }
 #endif
 
+/*
+  hash bucket for a format name. Names are matched by address, so
+  mix the address bits rather than hashing the string
+ */
+uint8_t AP_Logger::log_write_fmt_hash_bucket(const char *name)
+{
+    uint32_t h = (uint32_t)(uintptr_t)name;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h % log_write_fmt_hash_size;
+}
+
 AP_Logger::log_write_fmt *AP_Logger::msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt)
 {
+    const uint8_t bucket = log_write_fmt_hash_bucket(name);
     struct log_write_fmt *f;
-    for (f = log_write_fmts; f; f=f->next) {
+    for (f = log_write_fmt_hash[bucket]; f; f=f->hash_next) {
         if (f->name == name) { // ptr comparison
             // already have an ID for this name:
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -894,6 +908,8 @@ AP_Logger::log_write_fmt *AP_Logger::msg_fmt_for_name(const char *name, const ch
     // add to front of list
     f->next = log_write_fmts;
     log_write_fmts = f;
+    f->hash_next = log_write_fmt_hash[bucket];
+    log_write_fmt_hash[bucket] = f;
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     char ls_name[LS_NAME_SIZE] = {};
@@ -405,6 +405,7 @@ private:
     // efficiency of finding message types
     struct log_write_fmt {
         struct log_write_fmt *next;
+        struct log_write_fmt *hash_next; // next format in the same name_hash bucket
         uint8_t msg_type;
         uint8_t msg_len;
         uint8_t sent_mask; // bitmask of backends sent to
@@ -415,6 +416,12 @@ private:
         const char *mults;
     } *log_write_fmts;
 
+    // log_write_fmts hashed on the address of their name, so the
+    // format for a dynamic Write() is found without walking the list
+    static const uint8_t log_write_fmt_hash_size = 32;
+    struct log_write_fmt *log_write_fmt_hash[log_write_fmt_hash_size] {};
+    static uint8_t log_write_fmt_hash_bucket(const char *name);
+
     // return (possibly allocating) a log_write_fmt for a name
     struct log_write_fmt *msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt);
     const struct log_write_fmt *log_write_fmt_for_msg_type(uint8_t msg_type) const;
@@ -173,25 +173,18 @@ bool AP_Logger_Backend::Write_Emit_FMT(uint8_t msg_type)
     return true;
 }
 
-bool AP_Logger_Backend::Write(const uint8_t msg_type, va_list arg_list, bool is_critical)
+bool AP_Logger_Backend::Write(const AP_Logger::log_write_fmt *f, va_list arg_list, bool is_critical)
 {
     // stack-allocate a buffer so we can WriteBlock(); this could be
     // 255 bytes!  If we were willing to lose the WriteBlock
     // abstraction we could do WriteBytes() here instead?
-    const char *fmt  = nullptr;
-    uint8_t msg_len;
-    AP_Logger::log_write_fmt *f;
-    for (f = _front.log_write_fmts; f; f=f->next) {
-        if (f->msg_type == msg_type) {
-            fmt = f->fmt;
-            msg_len = f->msg_len;
-            break;
-        }
-    }
-    if (fmt == nullptr) {
+    if (f == nullptr || f->fmt == nullptr) {
         AP::internalerror().error(AP_InternalError::error_t::logger_logwrite_missingfmt);
         return false;
     }
+    const char *fmt = f->fmt;
+    const uint8_t msg_type = f->msg_type;
+    const uint8_t msg_len = f->msg_len;
     if (bufferspace_available() < msg_len) {
         return false;
     }
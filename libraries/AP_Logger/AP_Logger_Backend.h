@@ -110,9 +110,9 @@ public:
     // Returns true if the FMT message has ever been written.
     bool Write_Emit_FMT(uint8_t msg_type);
 
-    // write a log message out to the log of msg_type type, with
-    // values contained in arg_list:
-    bool Write(uint8_t msg_type, va_list arg_list, bool is_critical=false);
+    // write a log message out to the log using the dynamic format f,
+    // with values contained in arg_list:
+    bool Write(const AP_Logger::log_write_fmt *f, va_list arg_list, bool is_critical=false);
 
     // these methods are used when reporting system status over mavlink
     virtual bool logging_enabled() const = 0;
@@ -93,6 +93,34 @@ float *mat_mul(float *A, float *B, uint8_t n);
 // matrix algebra
 bool inverse(float x[], float y[], uint16_t dim) WARN_IF_UNUSED;
 
+// generic heap allocating inverse of an nxn matrix
+bool mat_inverse(float *A, float *inv, uint8_t n) WARN_IF_UNUSED;
+
+/*
+ * allocation-free algebra on NxN row-major matrices, instantiated for N
+ * from 5 to 12. x and y may point to the same matrix
+ */
+
+// in-place LU decomposition with partial pivoting, row permutation in perm
+template <uint8_t N>
+bool LU_decomposeN(float A[], uint8_t perm[]) WARN_IF_UNUSED;
+
+// solve A*x = b given the output of LU_decomposeN()
+template <uint8_t N>
+void LU_solveN(const float LU[], const uint8_t perm[], const float b[], float x[]);
+
+// A = L*L^T for a symmetric positive definite A, with L lower triangular
+template <uint8_t N>
+bool cholesky_decomposeN(const float A[], float L[]) WARN_IF_UNUSED;
+
+// y is the inverse of x when returns true, otherwise x is singular
+template <uint8_t N>
+bool inverseN(const float x[], float y[]) WARN_IF_UNUSED;
+
+// as inverseN() but only for symmetric positive definite matrices
+template <uint8_t N>
+bool inverse_spdN(const float x[], float y[]) WARN_IF_UNUSED;
+
 /*
  * Constrain an angle to be within the range: -180 to 180 degrees. The second
  * parameter changes the units. Default: 1 == degrees, 10 == dezi,
@@ -0,0 +1,69 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+/*
+ * well conditioned symmetric positive definite test matrix, similar to the
+ * normal equations built by the accelerometer calibration fit
+ */
+template <uint8_t N>
+static void fill_test_matrix(float m[])
+{
+    for (uint8_t i = 0; i < N; i++) {
+        for (uint8_t j = 0; j < N; j++) {
+            m[i*N + j] = 1.0f / (1 + i + j);
+        }
+        m[i*N + i] += N;
+    }
+}
+
+template <uint8_t N>
+static void BM_MatInverseHeap(benchmark::State& state)
+{
+    float m[N*N], inv[N*N];
+    fill_test_matrix<N>(m);
+
+    while (state.KeepRunning()) {
+        bool ok = mat_inverse(m, inv, N);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(inv);
+    }
+}
+
+template <uint8_t N>
+static void BM_InverseN(benchmark::State& state)
+{
+    float m[N*N], inv[N*N];
+    fill_test_matrix<N>(m);
+
+    while (state.KeepRunning()) {
+        bool ok = inverseN<N>(m, inv);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(inv);
+    }
+}
+
+template <uint8_t N>
+static void BM_InverseSPDN(benchmark::State& state)
+{
+    float m[N*N], inv[N*N];
+    fill_test_matrix<N>(m);
+
+    while (state.KeepRunning()) {
+        bool ok = inverse_spdN<N>(m, inv);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(inv);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_MatInverseHeap, 6);
+BENCHMARK_TEMPLATE(BM_InverseN, 6);
+BENCHMARK_TEMPLATE(BM_InverseSPDN, 6);
+BENCHMARK_TEMPLATE(BM_MatInverseHeap, 9);
+BENCHMARK_TEMPLATE(BM_InverseN, 9);
+BENCHMARK_TEMPLATE(BM_InverseSPDN, 9);
+BENCHMARK_TEMPLATE(BM_MatInverseHeap, 12);
+BENCHMARK_TEMPLATE(BM_InverseN, 12);
+BENCHMARK_TEMPLATE(BM_InverseSPDN, 12);
+
+BENCHMARK_MAIN()
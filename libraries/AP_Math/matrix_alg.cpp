@@ -188,7 +188,7 @@ static void mat_LU_decompose(float* A, float* L, float* U, float *P, uint8_t n)
  *    @param     n,           dimension of square matrix
  *    @returns                false = matrix is Singular, true = matrix inversion successful
  */
-static bool mat_inverse(float* A, float* inv, uint8_t n)
+bool mat_inverse(float* A, float* inv, uint8_t n)
 {
     float *L, *U, *P;
     bool ret = true;
@@ -422,6 +422,218 @@ bool inverse4x4(float m[],float invOut[])
     return true;
 }
 
+/*
+ *    LU decomposition with partial pivoting of a fixed size matrix, done in
+ *    place so no memory is allocated. On return A holds L below the diagonal
+ *    (with an implicit unit diagonal) and U on and above it, such that
+ *    P*A = L*U where P is the row permutation given by perm
+ *
+ *    @param     A,           input NxN matrix, output packed L and U
+ *    @param     perm,        output row permutation
+ *    @returns                false = matrix is Singular, true = decomposition successful
+ */
+template <uint8_t N>
+bool LU_decomposeN(float A[], uint8_t perm[])
+{
+    for (uint8_t i = 0; i < N; i++) {
+        perm[i] = i;
+    }
+
+    for (uint8_t k = 0; k < N; k++) {
+        // pick the largest remaining element of this column as pivot
+        uint8_t max_i = k;
+        float max_v = fabsf(A[k*N + k]);
+        for (uint8_t i = k+1; i < N; i++) {
+            if (fabsf(A[i*N + k]) > max_v) {
+                max_v = fabsf(A[i*N + k]);
+                max_i = i;
+            }
+        }
+        // also catches NaN
+        if (!(max_v > 0.0f)) {
+            return false;
+        }
+
+        if (max_i != k) {
+            for (uint8_t j = 0; j < N; j++) {
+                swap(A[k*N + j], A[max_i*N + j]);
+            }
+            const uint8_t tmp = perm[k];
+            perm[k] = perm[max_i];
+            perm[max_i] = tmp;
+        }
+
+        const float inv_pivot = 1.0f / A[k*N + k];
+        for (uint8_t i = k+1; i < N; i++) {
+            const float factor = A[i*N + k] * inv_pivot;
+            A[i*N + k] = factor;
+            for (uint8_t j = k+1; j < N; j++) {
+                A[i*N + j] -= factor * A[k*N + j];
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ *    solves A*x = b using the output of LU_decomposeN()
+ *
+ *    @param     LU,          packed L and U matrices
+ *    @param     perm,        row permutation
+ *    @param     b,           right hand side vector
+ *    @param     x,           output solution vector
+ */
+template <uint8_t N>
+void LU_solveN(const float LU[], const uint8_t perm[], const float b[], float x[])
+{
+    // forward substitution solve L*y = P*b
+    for (uint8_t i = 0; i < N; i++) {
+        float sum = b[perm[i]];
+        for (uint8_t j = 0; j < i; j++) {
+            sum -= LU[i*N + j] * x[j];
+        }
+        x[i] = sum;
+    }
+    // backward substitution solve U*x = y
+    for (int8_t i = N-1; i >= 0; i--) {
+        float sum = x[i];
+        for (uint8_t j = i+1; j < N; j++) {
+            sum -= LU[i*N + j] * x[j];
+        }
+        x[i] = sum / LU[i*N + i];
+    }
+}
+
+/*
+ *    Cholesky decomposition of a fixed size symmetric positive definite
+ *    matrix. Only the lower triangle of A is used. A and L may be the same
+ *
+ *    @param     A,           input NxN matrix
+ *    @param     L,           output lower triangular matrix
+ *    @returns                false = matrix is not positive definite, true = decomposition successful
+ */
+template <uint8_t N>
+bool cholesky_decomposeN(const float A[], float L[])
+{
+    for (uint8_t i = 0; i < N; i++) {
+        for (uint8_t j = 0; j <= i; j++) {
+            float sum = A[i*N + j];
+            for (uint8_t k = 0; k < j; k++) {
+                sum -= L[i*N + k] * L[j*N + k];
+            }
+            if (i == j) {
+                // also catches NaN
+                if (!(sum > 0.0f)) {
+                    return false;
+                }
+                L[i*N + i] = sqrtf(sum);
+            } else {
+                L[i*N + j] = sum / L[j*N + j];
+            }
+        }
+        for (uint8_t j = i+1; j < N; j++) {
+            L[i*N + j] = 0;
+        }
+    }
+    return true;
+}
+
+/*
+ *    matrix inverse of a fixed size square matrix using LU decomposition
+ *    with partial pivoting. All intermediate storage is on the stack
+ *
+ *    @param     x,           input NxN matrix
+ *    @param     y,           Output inverted NxN matrix
+ *    @returns                false = matrix is Singular, true = matrix inversion successful
+ */
+template <uint8_t N>
+bool inverseN(const float x[], float y[])
+{
+    float LU[N*N];
+    uint8_t perm[N];
+
+    memcpy(LU, x, sizeof(LU));
+    if (!LU_decomposeN<N>(LU, perm)) {
+        return false;
+    }
+
+    // solve for each column of the identity matrix in turn
+    for (uint8_t c = 0; c < N; c++) {
+        float e[N] {};
+        float col[N];
+        e[c] = 1;
+        LU_solveN<N>(LU, perm, e, col);
+        for (uint8_t r = 0; r < N; r++) {
+            if (isnan(col[r]) || isinf(col[r])) {
+                return false;
+            }
+            y[r*N + c] = col[r];
+        }
+    }
+    return true;
+}
+
+/*
+ *    matrix inverse of a fixed size symmetric positive definite matrix using
+ *    Cholesky decomposition. inv = inv(L)^T * inv(L)
+ *
+ *    @param     x,           input NxN matrix
+ *    @param     y,           Output inverted NxN matrix
+ *    @returns                false = matrix is not positive definite, true = matrix inversion successful
+ */
+template <uint8_t N>
+bool inverse_spdN(const float x[], float y[])
+{
+    float L[N*N];
+    if (!cholesky_decomposeN<N>(x, L)) {
+        return false;
+    }
+
+    // forward substitution solve L*Linv = I, in place in L
+    for (uint8_t i = 0; i < N; i++) {
+        const float inv_diag = 1.0f / L[i*N + i];
+        for (uint8_t j = 0; j < i; j++) {
+            float sum = 0;
+            for (uint8_t k = j; k < i; k++) {
+                sum -= L[i*N + k] * L[k*N + j];
+            }
+            L[i*N + j] = sum * inv_diag;
+        }
+        L[i*N + i] = inv_diag;
+    }
+
+    for (uint8_t i = 0; i < N; i++) {
+        for (uint8_t j = 0; j <= i; j++) {
+            float sum = 0;
+            for (uint8_t k = i; k < N; k++) {
+                sum += L[k*N + i] * L[k*N + j];
+            }
+            if (isnan(sum) || isinf(sum)) {
+                return false;
+            }
+            y[i*N + j] = sum;
+            y[j*N + i] = sum;
+        }
+    }
+    return true;
+}
+
+#define MATRIX_ALG_INSTANTIATE(N) \
+    template bool LU_decomposeN<N>(float A[], uint8_t perm[]); \
+    template void LU_solveN<N>(const float LU[], const uint8_t perm[], const float b[], float x[]); \
+    template bool cholesky_decomposeN<N>(const float A[], float L[]); \
+    template bool inverseN<N>(const float x[], float y[]); \
+    template bool inverse_spdN<N>(const float x[], float y[])
+
+MATRIX_ALG_INSTANTIATE(5);
+MATRIX_ALG_INSTANTIATE(6);
+MATRIX_ALG_INSTANTIATE(7);
+MATRIX_ALG_INSTANTIATE(8);
+MATRIX_ALG_INSTANTIATE(9);
+MATRIX_ALG_INSTANTIATE(10);
+MATRIX_ALG_INSTANTIATE(11);
+MATRIX_ALG_INSTANTIATE(12);
+
 /*
  *    generic matrix inverse code
  *
@@ -435,6 +647,14 @@ bool inverse(float x[], float y[], uint16_t dim)
     switch(dim){
         case 3: return inverse3x3(x,y);
         case 4: return inverse4x4(x,y);
+        case 5: return inverseN<5>(x,y);
+        case 6: return inverseN<6>(x,y);
+        case 7: return inverseN<7>(x,y);
+        case 8: return inverseN<8>(x,y);
+        case 9: return inverseN<9>(x,y);
+        case 10: return inverseN<10>(x,y);
+        case 11: return inverseN<11>(x,y);
+        case 12: return inverseN<12>(x,y);
         default: return mat_inverse(x,y,dim);
     }
 }
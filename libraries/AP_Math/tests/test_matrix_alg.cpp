@@ -0,0 +1,80 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+/*
+ * check that a*b is the NxN identity matrix
+ */
+template <uint8_t N>
+static void expect_identity_product(const float a[], const float b[])
+{
+    for (uint8_t i = 0; i < N; i++) {
+        for (uint8_t j = 0; j < N; j++) {
+            float sum = 0;
+            for (uint8_t k = 0; k < N; k++) {
+                sum += a[i*N + k] * b[k*N + j];
+            }
+            EXPECT_NEAR(i == j ? 1.0f : 0.0f, sum, 1.0e-4f);
+        }
+    }
+}
+
+template <uint8_t N>
+static void fill_spd_matrix(float m[])
+{
+    for (uint8_t i = 0; i < N; i++) {
+        for (uint8_t j = 0; j < N; j++) {
+            m[i*N + j] = 1.0f / (1 + i + j);
+        }
+        m[i*N + i] += N;
+    }
+}
+
+template <uint8_t N>
+static void check_inverses()
+{
+    float m[N*N], inv[N*N];
+
+    fill_spd_matrix<N>(m);
+    // make it non-symmetric and needing row swaps
+    m[N-1] = 3*N;
+
+    ASSERT_TRUE(inverseN<N>(m, inv));
+    expect_identity_product<N>(m, inv);
+
+    float generic[N*N];
+    memcpy(generic, m, sizeof(generic));
+    ASSERT_TRUE(inverse(generic, generic, N));
+    for (uint8_t i = 0; i < N*N; i++) {
+        EXPECT_NEAR(inv[i], generic[i], 1.0e-5f);
+    }
+
+    fill_spd_matrix<N>(m);
+    ASSERT_TRUE(inverse_spdN<N>(m, inv));
+    expect_identity_product<N>(m, inv);
+}
+
+TEST(MatrixAlgTest, InverseN)
+{
+    check_inverses<6>();
+    check_inverses<9>();
+    check_inverses<12>();
+}
+
+TEST(MatrixAlgTest, Singular)
+{
+    float m[6*6] {};
+    float inv[6*6];
+
+    EXPECT_FALSE(inverseN<6>(m, inv));
+    EXPECT_FALSE(inverse_spdN<6>(m, inv));
+
+    // invertible but not positive definite
+    for (uint8_t i = 0; i < 6; i++) {
+        m[i*6 + i] = -1;
+    }
+    EXPECT_TRUE(inverseN<6>(m, inv));
+    EXPECT_FALSE(inverse_spdN<6>(m, inv));
+}
+
+AP_GTEST_MAIN()
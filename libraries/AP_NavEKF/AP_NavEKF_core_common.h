@@ -20,6 +20,21 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
 
+/*
+  on Linux the EKF3 cores may be stepped from several threads at once
+  (see HAL_NAVEKF3_PARALLEL_CORES), so each thread needs its own copy
+  of the scratch space
+ */
+#ifndef HAL_NAVEKF_SCRATCH_THREAD_LOCAL
+#define HAL_NAVEKF_SCRATCH_THREAD_LOCAL (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+#if HAL_NAVEKF_SCRATCH_THREAD_LOCAL
+#define NAVEKF_SCRATCH thread_local
+#else
+#define NAVEKF_SCRATCH
+#endif
+
 /*
   this declares a common parent class for AP_NavEKF2 and
   AP_NavEKF3. The purpose of this class is to hold common static
@@ -42,10 +57,10 @@ public:
 #endif
 
 protected:
-    static Matrix24 KH;                   // intermediate result used for covariance updates
-    static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
-    static Vector28 Kfusion;              // intermediate fusion vector
+    static NAVEKF_SCRATCH Matrix24 KH;    // intermediate result used for covariance updates
+    static NAVEKF_SCRATCH Matrix24 KHP;   // intermediate result used for covariance updates
+    static NAVEKF_SCRATCH Matrix24 nextP; // Predicted covariance matrix before addition of process noise to diagonals
+    static NAVEKF_SCRATCH Vector28 Kfusion; // intermediate fusion vector
 
     // fill all the common scratch variables with NaN on SITL
     void fill_scratch_variables(void);
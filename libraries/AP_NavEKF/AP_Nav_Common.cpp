@@ -23,3 +23,24 @@ void Log_EKF_Timing(const char *name, uint64_t time_us, const struct ekf_timing
         (double)timing.delVelDT_min,
         (double)timing.delVelDT_max);
 }
+
+/*
+  write an EKF observation buffer statistics message
+ */
+void Log_EKF_Buffers(const char *name, uint64_t time_us, const struct ekf_buffer_stats &stats)
+{
+    AP::logger().Write(
+        name,
+        "TimeUS,GPS,Mag,Baro,TAS,Rng,Flow,BOdm,WOdm,Ovr",
+        "QBBBBBBBBI",
+        time_us,
+        stats.gps,
+        stats.mag,
+        stats.baro,
+        stats.tas,
+        stats.range,
+        stats.flow,
+        stats.bodyOdm,
+        stats.wheelOdm,
+        stats.overruns);
+}
@@ -76,3 +76,22 @@ struct ekf_timing {
     float delVelDT_min;
 };
 void Log_EKF_Timing(const char *name, uint64_t time_us, const struct ekf_timing &timing);
+
+/*
+  observation buffer statistics, used to check that buffer lengths
+  match the sensor latencies
+ */
+struct ekf_buffer_stats {
+    // largest number of samples waiting to be fused in each buffer
+    uint8_t gps;
+    uint8_t mag;
+    uint8_t baro;
+    uint8_t tas;
+    uint8_t range;
+    uint8_t flow;
+    uint8_t bodyOdm;
+    uint8_t wheelOdm;
+    // total number of samples overwritten before they could be fused
+    uint32_t overruns;
+};
+void Log_EKF_Buffers(const char *name, uint64_t time_us, const struct ekf_buffer_stats &stats);
@@ -1613,6 +1613,21 @@ void NavEKF2::getTimingStatistics(int8_t instance, struct ekf_timing &timing) co
     }
 }
 
+/*
+  get observation buffer statistics for an EKF2 instance
+*/
+void NavEKF2::getBufferStatistics(int8_t instance, struct ekf_buffer_stats &stats)
+{
+    if (instance < 0 || instance >= num_cores) {
+        instance = primary;
+    }
+    if (core) {
+        core[instance].getBufferStatistics(stats);
+    } else {
+        memset(&stats, 0, sizeof(stats));
+    }
+}
+
 /*
  * Write position and quaternion data from an external navigation system
  *
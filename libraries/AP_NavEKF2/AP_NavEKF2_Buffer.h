@@ -24,6 +24,11 @@ public:
         _head = 0;
         _tail = 0;
         _new_data = false;
+        _unordered = 0;
+        _waiting = 0;
+        _overruns = 0;
+        _max_occupancy = 0;
+        _last_push_ms = 0;
         return true;
     }
 
@@ -51,6 +56,29 @@ public:
                     _new_data = false;
                 }
             }
+        } else if (_unordered == 0) {
+            // time stamps from tail to head are monotonic, so binary
+            // search for the newest one that is not after sample_time
+            uint8_t low = 0;
+            uint8_t high = (_head + _size - tail) % _size;
+            while (low < high) {
+                const uint8_t mid = (low + high) / 2;
+                if (buffer[(tail+mid)%_size].element.time_ms <= sample_time) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            // older entries are older still, so only the newest
+            // candidate can be within the time horizon window
+            if (low > 0) {
+                const uint8_t index = (tail+low-1)%_size;
+                if (buffer[index].element.time_ms != 0 &&
+                    ((sample_time - buffer[index].element.time_ms) < 100)) {
+                    bestIndex = index;
+                    success = true;
+                }
+            }
         } else {
             while(_head != tail) {
                 // find a measurement older than the fusion time horizon that we haven't checked before
@@ -70,6 +98,8 @@ public:
         if (success) {
             element = buffer[bestIndex].element;
             _tail = (bestIndex+1)%_size;
+            // everything up to and including bestIndex is now used or stale
+            _waiting = _new_data ? (_head + _size - bestIndex) % _size : 0;
             //make time zero to stop using it again,
             //resolves corner case of reusing the element when head == tail
             buffer[bestIndex].element.time_ms = 0;
@@ -85,17 +115,38 @@ public:
     */
     inline void push(element_type element)
     {
+        // a time stamp going backwards disables the binary search in
+        // recall() until every element in the buffer has been
+        // replaced by data pushed in order. The last time stamp is
+        // kept separately as recall() zeroes the ones it returns
+        if (element.time_ms < _last_push_ms) {
+            _unordered = _size;
+        } else if (_unordered > 0) {
+            _unordered--;
+        }
+        _last_push_ms = element.time_ms;
         // Advance head to next available index
         _head = (_head+1)%_size;
         // New data is written at the head
         buffer[_head].element = element;
         _new_data = true;
+        if (_waiting < _size) {
+            _waiting++;
+        } else {
+            // oldest data was overwritten before it could be recalled
+            _overruns++;
+        }
+        if (_waiting > _max_occupancy) {
+            _max_occupancy = _waiting;
+        }
     }
     // writes the same data to all elements in the ring buffer
     inline void reset_history(element_type element, uint32_t sample_time) {
         for (uint8_t index=0; index<_size; index++) {
             buffer[index].element = element;
         }
+        _unordered = 0;
+        _last_push_ms = element.time_ms;
     }
 
     // zeroes all data in the ring buffer
@@ -103,11 +154,32 @@ public:
         _head = 0;
         _tail = 0;
         _new_data = false;
+        _unordered = 0;
+        _waiting = 0;
+        _last_push_ms = 0;
         memset((void *)buffer,0,_size*sizeof(element_t));
     }
 
+    // number of times unrecalled data has been overwritten
+    uint32_t get_overruns() const {
+        return _overruns;
+    }
+
+    // return the largest number of samples waiting to be recalled
+    // since the last call
+    uint8_t take_max_occupancy() {
+        const uint8_t ret = _max_occupancy;
+        _max_occupancy = 0;
+        return ret;
+    }
+
 private:
     uint8_t _size,_head,_tail,_new_data;
+    uint8_t _unordered;     // pushes left before time stamps are known to be monotonic again
+    uint8_t _waiting;       // samples pushed but not yet recalled or skipped as stale
+    uint8_t _max_occupancy;
+    uint32_t _overruns;
+    uint32_t _last_push_ms; // time stamp of the newest pushed data
 };
 
 
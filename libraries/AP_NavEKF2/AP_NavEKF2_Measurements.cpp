@@ -880,6 +880,24 @@ void NavEKF2_core::getTimingStatistics(struct ekf_timing &_timing)
     memset(&timing, 0, sizeof(timing));
 }
 
+// get observation buffer statistics, resetting the occupancy high water marks
+void NavEKF2_core::getBufferStatistics(struct ekf_buffer_stats &stats)
+{
+    stats.gps = storedGPS.take_max_occupancy();
+    stats.mag = storedMag.take_max_occupancy();
+    stats.baro = storedBaro.take_max_occupancy();
+    stats.tas = storedTAS.take_max_occupancy();
+    stats.range = storedRange.take_max_occupancy();
+    stats.flow = storedOF.take_max_occupancy();
+    // EKF2 has no body frame or wheel odometry buffers
+    stats.bodyOdm = 0;
+    stats.wheelOdm = 0;
+    stats.overruns = storedGPS.get_overruns() + storedMag.get_overruns() +
+        storedBaro.get_overruns() + storedTAS.get_overruns() +
+        storedRange.get_overruns() + storedOF.get_overruns() +
+        storedRangeBeacon.get_overruns() + storedExtNav.get_overruns();
+}
+
 void NavEKF2_core::writeExtNavData(const Vector3f &sensOffset, const Vector3f &pos, const Quaternion &quat, float posErr, float angErr, uint32_t timeStamp_ms, uint32_t resetTime_ms)
 {
     // limit update rate to maximum allowed by sensor buffers and fusion process
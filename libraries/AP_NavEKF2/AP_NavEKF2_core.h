@@ -310,6 +310,9 @@ public:
 
     // get timing statistics structure
     void getTimingStatistics(struct ekf_timing &timing);
+
+    // get observation buffer statistics, resetting the occupancy high water marks
+    void getBufferStatistics(struct ekf_buffer_stats &stats);
     
     /*
      * Write position and quaternion data from an external navigation system
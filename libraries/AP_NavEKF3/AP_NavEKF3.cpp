@@ -7,6 +7,10 @@
 #include <AP_GPS/AP_GPS.h>
 #include <new>
 
+#if HAL_NAVEKF3_PARALLEL_CORES
+#include <unistd.h>
+#endif
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -604,6 +608,16 @@ const AP_Param::GroupInfo NavEKF3::var_info[] = {
     // @Units: mGauss
     AP_GROUPINFO("MAG_EF_LIM", 56, NavEKF3, _mag_ef_limit, 50),
 
+#if HAL_NAVEKF3_PARALLEL_CORES
+    // @Param: THREADS
+    // @DisplayName: Run EKF cores in parallel threads
+    // @Description: When enabled and more than one EKF core is running on a multi-core board, each additional core is stepped in its own worker thread pinned to a separate CPU. The cores are joined before core selection, so prediction steps no longer need to be skipped to share the loop time between cores.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("THREADS", 57, NavEKF3, _coreThreads, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -614,6 +628,15 @@ NavEKF3::NavEKF3(const AP_AHRS *ahrs, const RangeFinder &rng) :
     AP_Param::setup_object_defaults(this, var_info);
 }
 
+#if HAL_NAVEKF3_PARALLEL_CORES
+NavEKF3::~NavEKF3()
+{
+    Linux::WorkerThread *workers = core_workers;
+    core_workers = nullptr;
+    stop_core_workers(workers, num_cores-1);
+}
+#endif
+
 /*
   see if we should log some sensor data
  */
@@ -703,6 +726,10 @@ bool NavEKF3::InitialiseFilter(void)
         for (uint8_t i = 0; i < num_cores; i++) {
             new (&core[i]) NavEKF3_core(this);
         }
+
+#if HAL_NAVEKF3_PARALLEL_CORES
+        start_core_workers();
+#endif
     }
 
     // Set up any cores that have been created
@@ -719,6 +746,7 @@ bool NavEKF3::InitialiseFilter(void)
     }
     // exit with failure if any cores could not be setup
     if (!core_setup_success) {
+        runCoreDeferred();
         return false;
     }
 
@@ -740,6 +768,8 @@ bool NavEKF3::InitialiseFilter(void)
     memset((void *)&pos_reset_data, 0, sizeof(pos_reset_data));
     memset(&pos_down_reset_data, 0, sizeof(pos_down_reset_data));
 
+    runCoreDeferred();
+
     check_log_write();
     return ret;
 }
@@ -755,21 +785,51 @@ void NavEKF3::UpdateFilter(void)
 
     const AP_InertialSensor &ins = AP::ins();
 
+#if HAL_NAVEKF3_PARALLEL_CORES
+    const bool parallel = (core_workers != nullptr);
+#else
+    const bool parallel = false;
+#endif
+
     bool statePredictEnabled[num_cores];
     for (uint8_t i=0; i<num_cores; i++) {
         // if we have not overrun by more than 3 IMU frames, and we
         // have already used more than 1/3 of the CPU budget for this
         // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+        // multiple EKF instances to cooperate on scheduling. When the
+        // cores run in parallel threads they don't share the budget
+        // so the prediction step is never suppressed
+        if (!parallel &&
+            core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
             (AP_HAL::micros() - ins.get_last_update_usec()) > _frameTimeUsec/3) {
             statePredictEnabled[i] = false;
         } else {
             statePredictEnabled[i] = true;
         }
-        core[i].UpdateFilter(statePredictEnabled[i]);
     }
 
+#if HAL_NAVEKF3_PARALLEL_CORES
+    if (parallel) {
+        // hand cores 1 and up to the workers, step core 0 ourselves
+        // then wait for all of them before running core selection
+        for (uint8_t i=1; i<num_cores; i++) {
+            core[i].threadPredict = statePredictEnabled[i];
+            core_workers[i-1].dispatch(FUNCTOR_BIND(&core[i], &NavEKF3_core::UpdateFilterThreaded, void));
+        }
+        core[0].UpdateFilter(statePredictEnabled[0]);
+        for (uint8_t i=1; i<num_cores; i++) {
+            core_workers[i-1].wait();
+        }
+    } else
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            core[i].UpdateFilter(statePredictEnabled[i]);
+        }
+    }
+
+    runCoreDeferred();
+
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
     // Don't start running the check until the primary core has started returned healthy for at least 10 seconds to avoid switching
     // due to initial alignment fluctuations and race conditions
@@ -825,6 +885,94 @@ void NavEKF3::UpdateFilter(void)
     check_log_write();
 }
 
+#if HAL_NAVEKF3_PARALLEL_CORES
+/*
+  start one worker thread for each core other than the first, pinned
+  round-robin to the CPUs not used by the main thread. If there is
+  only one core or one CPU there is nothing to gain and the cores are
+  stepped sequentially as usual
+ */
+void NavEKF3::start_core_workers(void)
+{
+    const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (_coreThreads == 0 || num_cores < 2 || num_cpus < 2) {
+        return;
+    }
+
+    Linux::WorkerThread *workers = new Linux::WorkerThread[num_cores-1];
+    if (workers == nullptr) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "NavEKF3: core threads allocation failed");
+        return;
+    }
+
+    for (uint8_t i=0; i<num_cores-1; i++) {
+        char name[16];
+        hal.util->snprintf(name, sizeof(name), "ap-ekf3-%u", (unsigned)(i+1));
+        // leave CPU 0 for the main thread
+        const int cpu = 1 + (i % (num_cpus-1));
+        if (!workers[i].start_pinned(name, cpu)) {
+            // fall back to sequential updates
+            stop_core_workers(workers, i);
+            gcs().send_text(MAV_SEVERITY_WARNING, "NavEKF3: failed to start core threads");
+            return;
+        }
+    }
+
+    core_workers = workers;
+    gcs().send_text(MAV_SEVERITY_INFO, "NavEKF3: %u cores in parallel threads", (unsigned)num_cores);
+}
+
+void NavEKF3::stop_core_workers(Linux::WorkerThread *workers, uint8_t num)
+{
+    if (workers == nullptr) {
+        return;
+    }
+    for (uint8_t i=0; i<num; i++) {
+        workers[i].stop();
+    }
+    for (uint8_t i=0; i<num; i++) {
+        workers[i].join();
+    }
+    delete[] workers;
+}
+#endif // HAL_NAVEKF3_PARALLEL_CORES
+
+/*
+  run the actions the cores could not do themselves as they may have
+  been in worker threads, such as GCS messages and parameter changes
+ */
+void NavEKF3::runCoreDeferred(void)
+{
+    bool baroCalibration = false;
+    for (uint8_t i=0; i<num_cores; i++) {
+        if (core[i].runDeferred()) {
+            baroCalibration = true;
+        }
+    }
+    if (baroCalibration) {
+        AP::baro().update_calibration();
+    }
+}
+
+// set the origin shared between cores
+void NavEKF3::setCommonOrigin(const Location &loc)
+{
+    WITH_SEMAPHORE(common_origin_sem);
+    common_EKF_origin = loc;
+    common_origin_valid = true;
+}
+
+// get the origin shared between cores, returns false if not yet set
+bool NavEKF3::getCommonOrigin(Location &loc)
+{
+    WITH_SEMAPHORE(common_origin_sem);
+    if (!common_origin_valid) {
+        return false;
+    }
+    loc = common_EKF_origin;
+    return true;
+}
+
 /*
   check if switching lanes will reduce the normalised
   innovations. This is called when the vehicle code is about to
@@ -1009,6 +1157,7 @@ bool NavEKF3::resetHeightDatum(void)
                 status = false;
             }
         }
+        runCoreDeferred();
     } else {
         status = false;
     }
@@ -1691,3 +1840,18 @@ void NavEKF3::getTimingStatistics(int8_t instance, struct ekf_timing &timing) co
     }
 }
 
+/*
+  get observation buffer statistics for an EKF3 instance
+*/
+void NavEKF3::getBufferStatistics(int8_t instance, struct ekf_buffer_stats &stats)
+{
+    if (instance < 0 || instance >= num_cores) {
+        instance = primary;
+    }
+    if (core) {
+        core[instance].getBufferStatistics(stats);
+    } else {
+        memset(&stats, 0, sizeof(stats));
+    }
+}
+
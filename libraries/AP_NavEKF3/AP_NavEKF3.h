@@ -27,6 +27,23 @@
 #include <AP_Compass/AP_Compass.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
 #include <AP_Logger/LogStructure.h>
+#include <AP_NavEKF/AP_NavEKF_core_common.h>
+
+/*
+  allow EKF cores to be run in parallel worker threads. This is only
+  supported on Linux boards where each lane can be pinned to its own CPU
+ */
+#ifndef HAL_NAVEKF3_PARALLEL_CORES
+#define HAL_NAVEKF3_PARALLEL_CORES HAL_NAVEKF_SCRATCH_THREAD_LOCAL
+#endif
+
+#if HAL_NAVEKF3_PARALLEL_CORES && !HAL_NAVEKF_SCRATCH_THREAD_LOCAL
+#error "HAL_NAVEKF3_PARALLEL_CORES requires HAL_NAVEKF_SCRATCH_THREAD_LOCAL"
+#endif
+
+#if HAL_NAVEKF3_PARALLEL_CORES
+#include <AP_HAL_Linux/Thread.h>
+#endif
 
 class NavEKF3_core;
 class AP_AHRS;
@@ -36,6 +53,9 @@ class NavEKF3 {
 
 public:
     NavEKF3(const AP_AHRS *ahrs, const RangeFinder &rng);
+#if HAL_NAVEKF3_PARALLEL_CORES
+    ~NavEKF3();
+#endif
 
     /* Do not allow copies */
     NavEKF3(const NavEKF3 &other) = delete;
@@ -374,6 +394,9 @@ public:
     // get timing statistics structure
     void getTimingStatistics(int8_t instance, struct ekf_timing &timing) const;
 
+    // get observation buffer statistics for an EKF3 instance
+    void getBufferStatistics(int8_t instance, struct ekf_buffer_stats &stats);
+
     /*
       check if switching lanes will reduce the normalised
       innovations. This is called when the vehicle code is about to
@@ -450,6 +473,9 @@ private:
     AP_Int8  _flowUse;              // Controls if the optical flow data is fused into the main navigation estimator and/or the terrain estimator.
     AP_Float _hrt_filt_freq;        // frequency of output observer height rate complementary filter in Hz
     AP_Int16 _mag_ef_limit;         // limit on difference between WMM tables and learned earth field.
+#if HAL_NAVEKF3_PARALLEL_CORES
+    AP_Int8 _coreThreads;           // non-zero to run each core in its own worker thread
+#endif
 
 // Possible values for _flowUse
 #define FLOW_USE_NONE    0
@@ -529,6 +555,29 @@ private:
     // origin set by one of the cores
     struct Location common_EKF_origin;
     bool common_origin_valid;
+    HAL_Semaphore common_origin_sem;
+
+    // set the origin shared between cores
+    void setCommonOrigin(const Location &loc);
+
+    // get the origin shared between cores, returns false if not yet set
+    bool getCommonOrigin(Location &loc);
+
+#if HAL_NAVEKF3_PARALLEL_CORES
+    // worker threads running cores 1 to num_cores-1. Core 0 is always
+    // run on the calling thread
+    Linux::WorkerThread *core_workers = nullptr;
+
+    // start the core worker threads if enabled and useful on this system
+    void start_core_workers(void);
+
+    // stop and join num worker threads and free them
+    static void stop_core_workers(Linux::WorkerThread *workers, uint8_t num);
+#endif
+
+    // run the actions each core left for the main thread. Called
+    // after all the cores have been stepped
+    void runCoreDeferred(void);
     
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
@@ -354,6 +354,19 @@ void NavEKF3::Log_Write()
                 Log_EKF_Timing("XKT3", time_us, timing);
             }
         }
+
+        // log observation buffer occupancy and overruns over the same period
+        struct ekf_buffer_stats buffers;
+        for (uint8_t i=0; i<activeCores(); i++) {
+            getBufferStatistics(i, buffers);
+            if (i == 0) {
+                Log_EKF_Buffers("XKB1", time_us, buffers);
+            } else if (i == 1) {
+                Log_EKF_Buffers("XKB2", time_us, buffers);
+            } else if (i == 2) {
+                Log_EKF_Buffers("XKB3", time_us, buffers);
+            }
+        }
     }
 }
 
@@ -280,7 +280,7 @@ void NavEKF3_core::readMagData()
                 // if the magnetometer is allowed to be used for yaw and has a different index, we start using it
                 if (_ahrs->get_compass()->use_for_yaw(tempIndex) && tempIndex != magSelectIndex) {
                     magSelectIndex = tempIndex;
-                    gcs().send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
+                    sendText(MAV_SEVERITY_INFO, "EKF3 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
                     // reset the timeout flag and timer
                     magTimeout = false;
                     lastHealthyMagTime_ms = imuSampleTime_ms;
@@ -583,28 +583,34 @@ void NavEKF3_core::readGpsData()
             // Post-alignment checks
             calcGpsGoodForFlight();
 
-            // see if we can get an origin from the frontend
-            if (!validOrigin && frontend->common_origin_valid) {
-                setOrigin(frontend->common_EKF_origin);
-            }
-
             // Read the GPS location in WGS-84 lat,long,height coordinates
             const struct Location &gpsloc = gps.location();
 
-            // Set the EKF origin and magnetic field declination if not previously set and GPS checks have passed
-            if (gpsGoodToAlign && !validOrigin) {
-                setOrigin(gpsloc);
+            // see if we can get an origin from the frontend, else set
+            // our own. Other cores may be doing the same in parallel, so
+            // the check and the set are done holding the origin semaphore
+            {
+                WITH_SEMAPHORE(frontend->common_origin_sem);
 
-                // set the NE earth magnetic field states using the published declination
-                // and set the corresponding variances and covariances
-                alignMagStateDeclination();
+                Location common_origin;
+                if (!validOrigin && frontend->getCommonOrigin(common_origin)) {
+                    setOrigin(common_origin);
+                }
 
-                // Set the height of the NED origin
-                ekfGpsRefHgt = (double)0.01 * (double)gpsloc.alt + (double)outputDataNew.position.z;
+                // Set the EKF origin and magnetic field declination if not previously set and GPS checks have passed
+                if (gpsGoodToAlign && !validOrigin) {
+                    setOrigin(gpsloc);
 
-                // Set the uncertainty of the GPS origin height
-                ekfOriginHgtVar = sq(gpsHgtAccuracy);
+                    // set the NE earth magnetic field states using the published declination
+                    // and set the corresponding variances and covariances
+                    alignMagStateDeclination();
 
+                    // Set the height of the NED origin
+                    ekfGpsRefHgt = (double)0.01 * (double)gpsloc.alt + (double)outputDataNew.position.z;
+
+                    // Set the uncertainty of the GPS origin height
+                    ekfOriginHgtVar = sq(gpsHgtAccuracy);
+                }
             }
 
             if (gpsGoodToAlign && !have_table_earth_field) {
@@ -951,6 +957,23 @@ void NavEKF3_core::getTimingStatistics(struct ekf_timing &_timing)
     memset(&timing, 0, sizeof(timing));
 }
 
+// get observation buffer statistics, resetting the occupancy high water marks
+void NavEKF3_core::getBufferStatistics(struct ekf_buffer_stats &stats)
+{
+    stats.gps = storedGPS.take_max_occupancy();
+    stats.mag = storedMag.take_max_occupancy();
+    stats.baro = storedBaro.take_max_occupancy();
+    stats.tas = storedTAS.take_max_occupancy();
+    stats.range = storedRange.take_max_occupancy();
+    stats.flow = storedOF.take_max_occupancy();
+    stats.bodyOdm = storedBodyOdm.take_max_occupancy();
+    stats.wheelOdm = storedWheelOdm.take_max_occupancy();
+    stats.overruns = storedGPS.get_overruns() + storedMag.get_overruns() +
+        storedBaro.get_overruns() + storedTAS.get_overruns() +
+        storedRange.get_overruns() + storedOF.get_overruns() +
+        storedBodyOdm.get_overruns() + storedWheelOdm.get_overruns();
+}
+
 /*
   update estimates of inactive bias states. This keeps inactive IMUs
   as hot-spares so we can switch to them without causing a jump in the
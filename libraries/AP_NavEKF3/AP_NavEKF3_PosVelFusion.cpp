@@ -211,8 +211,9 @@ bool NavEKF3_core::resetHeightDatum(void)
     }
     // record the old height estimate
     float oldHgt = -stateStruct.position.z;
-    // reset the barometer so that it reads zero at the current height
-    AP::baro().update_calibration();
+    // reset the barometer so that it reads zero at the current height,
+    // once all the cores have been reset
+    deferred.baroCalibration = true;
     // reset the height state
     stateStruct.position.z = 0.0f;
     // adjust the height of the EKF origin so that the origin plus baro height before and after the reset is the same
@@ -1508,7 +1509,7 @@ void NavEKF3_core::FuseBodyVel()
             // notify first time only
             if (!bodyVelFusionActive) {
                 bodyVelFusionActive = true;
-                gcs().send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u fusing odometry",(unsigned)imu_index);
+                sendText(MAV_SEVERITY_INFO, "EKF3 IMU%u fusing odometry",(unsigned)imu_index);
             }
             // correct the covariance P = (I - K*H)*P
             // take advantage of the empty columns in KH to reduce the
@@ -95,8 +95,7 @@ void NavEKF3_core::calcGpsGoodToAlign(void)
         // EK3_GPS_TYPE=0 then change it to 1. It means the GPS is not
         // capable of giving a vertical velocity
         if (gps.status() >= AP_GPS::GPS_OK_FIX_3D) {
-            frontend->_fusionModeGPS.set(1);
-            gcs().send_text(MAV_SEVERITY_WARNING, "EK3: Changed EK3_GPS_TYPE to 1");
+            deferred.gpsTypeChange = true;
         }
     } else {
         gpsVertVelFail = false;
@@ -66,6 +66,8 @@ class AP_AHRS;
 
 class NavEKF3_core : public NavEKF_core_common
 {
+    friend class NavEKF3_core_Benchmark;
+
 public:
     // Constructor
     NavEKF3_core(NavEKF3 *_frontend);
@@ -81,6 +83,15 @@ public:
     // The predict flag is set true when a new prediction cycle can be started
     void UpdateFilter(bool predict);
 
+    // Run UpdateFilter() with the predict flag saved by the frontend in
+    // threadPredict. Used when the core is stepped from a worker thread
+    void UpdateFilterThreaded(void) { UpdateFilter(threadPredict); }
+    bool threadPredict;
+
+    // run the actions the core left for the main thread, see
+    // deferred. Returns true if the barometer needs recalibrating
+    bool runDeferred(void);
+
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
@@ -367,6 +378,9 @@ public:
     // get timing statistics structure
     void getTimingStatistics(struct ekf_timing &timing);
 
+    // get observation buffer statistics, resetting the occupancy high water marks
+    void getBufferStatistics(struct ekf_buffer_stats &stats);
+
 private:
     // Reference to the global EKF frontend for parameters
     NavEKF3 *frontend;
@@ -377,6 +391,25 @@ private:
     uint8_t imu_buffer_length;
     uint8_t obs_buffer_length;
 
+    // actions on other libraries that are not safe from an EKF worker
+    // thread. The core records them here and the frontend runs them
+    // on the main thread through runDeferred()
+    struct {
+        bool baroCalibration;   // barometer to be zeroed at current height
+        bool gpsTypeChange;     // EK3_GPS_TYPE to be changed from 0 to 1
+#if HAL_NAVEKF3_PARALLEL_CORES
+        uint8_t numTexts;
+        struct {
+            MAV_SEVERITY severity;
+            char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+        } texts[4];
+#endif
+    } deferred;
+
+    // send a GCS text message, deferred to the main thread when cores
+    // can run in worker threads
+    void sendText(MAV_SEVERITY severity, const char *fmt, ...) FMT_PRINTF(3, 4);
+
     typedef float ftype;
 #if MATH_CHECK_INDEXES
     typedef VectorN<ftype,2> Vector2;
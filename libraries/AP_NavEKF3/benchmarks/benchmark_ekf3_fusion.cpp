@@ -0,0 +1,336 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  benchmarks for the EKF3 prediction and fusion kernels
+
+  Each kernel is timed on its own against a NavEKF3_core that is fed
+  the IMU, GPS, compass and optical flow samples of a steady 10m/s
+  circuit at 20m above ground. The filter states are pinned to the
+  circuit before each call so every iteration takes the full fusion
+  path instead of being rejected by the innovation gates.
+
+  The reported time is per kernel call. On Linux the label also gives
+  the hardware cache misses per call when perf events are available.
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_NavEKF3/AP_NavEKF3.h>
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+#include <AP_RangeFinder/RangeFinder.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+#define SAMPLE_COUNT     2048       // length of the sample stream
+#define SAMPLE_DT        0.012f     // EKF prediction interval (sec)
+#define CIRCUIT_RADIUS   50.0f      // (m)
+#define CIRCUIT_SPEED    10.0f      // (m/s)
+#define CIRCUIT_HEIGHT   20.0f      // height above ground (m)
+
+/*
+  count hardware cache misses across a benchmark loop
+ */
+class CacheMissCounter {
+public:
+    CacheMissCounter()
+    {
+#ifdef __linux__
+        struct perf_event_attr attr {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd != -1) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if (fd != -1) {
+            close(fd);
+        }
+#endif
+    }
+
+    // stop counting and put the misses per iteration into the benchmark label
+    void report(benchmark::State &state)
+    {
+        char label[40] = "cache-misses n/a";
+#ifdef __linux__
+        uint64_t count;
+        if (fd != -1) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) == sizeof(count) && state.iterations() > 0) {
+                snprintf(label, sizeof(label), "cache-misses/call=%.2f",
+                         (double)count / state.iterations());
+            }
+        }
+#endif
+        state.SetLabel(label);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+private:
+    int fd = -1;
+};
+
+/*
+  drives the private kernels of a NavEKF3_core
+ */
+class NavEKF3_core_Benchmark {
+public:
+    NavEKF3_core_Benchmark() :
+        ekf(nullptr, rng)
+    {
+        record();
+
+        // allocate the buffers the way setup_core() would for a
+        // 400Hz IMU and the default sensor delays, without needing
+        // the INS and GPS drivers to be running
+        core = new NavEKF3_core(&ekf);
+        core->dtEkfAvg = SAMPLE_DT;
+        core->imu_buffer_length = 20;
+        core->obs_buffer_length = 10;
+        if (!core->storedGPS.init(core->obs_buffer_length) ||
+            !core->storedMag.init(core->obs_buffer_length) ||
+            !core->storedBaro.init(core->obs_buffer_length) ||
+            !core->storedTAS.init(core->obs_buffer_length) ||
+            !core->storedOF.init(core->obs_buffer_length) ||
+            !core->storedBodyOdm.init(core->obs_buffer_length) ||
+            !core->storedWheelOdm.init(core->imu_buffer_length) ||
+            !core->storedYawAng.init(core->obs_buffer_length) ||
+            !core->storedRange.init(core->imu_buffer_length) ||
+            !core->storedRangeBeacon.init(core->imu_buffer_length) ||
+            !core->storedIMU.init(core->imu_buffer_length) ||
+            !core->storedOutput.init(core->imu_buffer_length)) {
+            AP_HAL::panic("EKF3 benchmark buffer allocation failed");
+        }
+        core->InitialiseVariables();
+        core->dtIMUavg = SAMPLE_DT;
+
+        // all 24 states active and aiding from GPS
+        core->stateIndexLim = 23;
+        core->inhibitDelAngBiasStates = false;
+        core->inhibitDelVelBiasStates = false;
+        core->inhibitMagStates = false;
+        core->inhibitWindStates = false;
+        core->PV_AidingMode = NavEKF3_core::AID_ABSOLUTE;
+        core->tiltAlignComplete = true;
+        core->motorsArmed = true;
+        core->runUpdates = true;
+        core->velTimeout = false;
+        core->posTimeout = false;
+        core->hgtTimeout = false;
+        core->useGpsVertVel = true;
+        core->gpsSpdAccuracy = 0.3f;
+        core->gpsPosAccuracy = 0.5f;
+        core->posDownObsNoise = sq(0.5f);
+        core->terrainState = 0.0f;
+        core->rngOnGnd = 0.05f;
+        // avoid the one-off GCS notification on the first flow fusion
+        core->flowFusionActive = true;
+
+        load(0);
+        core->stateStruct.earth_magfield = earth_field;
+        for (uint8_t i=0; i<core->imu_buffer_length; i++) {
+            core->storedIMU.push_youngest_element(samples[i].imu);
+        }
+        core->CovarianceInit();
+    }
+
+    ~NavEKF3_core_Benchmark()
+    {
+        delete core;
+    }
+
+    void CovariancePrediction(benchmark::State &state)
+    {
+        CacheMissCounter misses;
+        while (state.KeepRunning()) {
+            load(index++);
+            core->CovariancePrediction();
+        }
+        misses.report(state);
+    }
+
+    void FuseVelPosNED(benchmark::State &state)
+    {
+        CacheMissCounter misses;
+        while (state.KeepRunning()) {
+            load(index++);
+            core->fuseVelData = true;
+            core->fusePosData = true;
+            core->fuseHgtData = true;
+            core->FuseVelPosNED();
+        }
+        misses.report(state);
+    }
+
+    void FuseMagnetometer(benchmark::State &state)
+    {
+        CacheMissCounter misses;
+        while (state.KeepRunning()) {
+            load(index++);
+            core->FuseMagnetometer();
+        }
+        misses.report(state);
+    }
+
+    void FuseOptFlow(benchmark::State &state)
+    {
+        CacheMissCounter misses;
+        while (state.KeepRunning()) {
+            load(index++);
+            core->FuseOptFlow();
+        }
+        misses.report(state);
+    }
+
+    void calcOutputStates(benchmark::State &state)
+    {
+        CacheMissCounter misses;
+        while (state.KeepRunning()) {
+            load(index++);
+            core->calcOutputStates();
+        }
+        misses.report(state);
+    }
+
+private:
+    struct sample {
+        NavEKF3_core::imu_elements imu;
+        NavEKF3_core::gps_elements gps;
+        NavEKF3_core::mag_elements mag;
+        NavEKF3_core::of_elements of;
+        Quaternion quat;
+    };
+
+    // build the sample stream for the circuit
+    void record()
+    {
+        const float omega = CIRCUIT_SPEED / CIRCUIT_RADIUS;
+        for (uint16_t i=0; i<SAMPLE_COUNT; i++) {
+            struct sample &s = samples[i];
+            const float t = i * SAMPLE_DT;
+            const float yaw = wrap_PI(omega * t + M_PI_2);
+            Matrix3f Tbn;
+            s.quat.from_euler(0.0f, 0.0f, yaw);
+            s.quat.rotation_matrix(Tbn);
+
+            s.imu.delAng = Vector3f(0.0f, 0.0f, omega * SAMPLE_DT);
+            s.imu.delVel = Vector3f(0.0f, CIRCUIT_SPEED * omega, -GRAVITY_MSS) * SAMPLE_DT;
+            s.imu.delAngDT = SAMPLE_DT;
+            s.imu.delVelDT = SAMPLE_DT;
+            s.imu.time_ms = i * (uint32_t)(SAMPLE_DT * 1000);
+            s.imu.gyro_index = 0;
+            s.imu.accel_index = 0;
+
+            s.gps.pos = Vector2f(CIRCUIT_RADIUS * cosf(omega * t), CIRCUIT_RADIUS * sinf(omega * t));
+            s.gps.hgt = CIRCUIT_HEIGHT;
+            s.gps.vel = Vector3f(-CIRCUIT_SPEED * sinf(omega * t), CIRCUIT_SPEED * cosf(omega * t), 0.0f);
+            s.gps.time_ms = s.imu.time_ms;
+            s.gps.sensor_idx = 0;
+
+            s.mag.mag = Tbn.mul_transpose(earth_field);
+            s.mag.time_ms = s.imu.time_ms;
+
+            s.of.bodyRadXYZ = Vector3f(0.0f, 0.0f, omega);
+            s.of.flowRadXY = Vector2f(0.0f, -CIRCUIT_SPEED / CIRCUIT_HEIGHT);
+            s.of.flowRadXYcomp = s.of.flowRadXY;
+            s.of.body_offset = &flow_offset;
+            s.of.time_ms = s.imu.time_ms;
+        }
+    }
+
+    // load a sample into the fusion time horizon and pin the states to it
+    void load(uint32_t i)
+    {
+        const struct sample &s = samples[i % SAMPLE_COUNT];
+        core->imuDataNew = s.imu;
+        core->imuDataDelayed = s.imu;
+        core->imuSampleTime_ms = s.imu.time_ms;
+        core->gpsDataDelayed = s.gps;
+        core->magDataDelayed = s.mag;
+        core->ofDataDelayed = s.of;
+        core->hgtMea = s.gps.hgt;
+
+        core->stateStruct.quat = s.quat;
+        core->stateStruct.velocity = s.gps.vel;
+        core->stateStruct.position = Vector3f(s.gps.pos.x, s.gps.pos.y, -s.gps.hgt);
+        core->stateStruct.body_magfield.zero();
+        core->stateStruct.quat.inverse().rotation_matrix(core->prevTnb);
+    }
+
+    RangeFinder rng;
+    NavEKF3 ekf;
+    NavEKF3_core *core;
+    struct sample samples[SAMPLE_COUNT];
+    uint32_t index = 0;
+    const Vector3f earth_field {0.22f, 0.02f, 0.43f};
+    const Vector3f flow_offset;
+};
+
+static NavEKF3_core_Benchmark &harness()
+{
+    static NavEKF3_core_Benchmark *bench = new NavEKF3_core_Benchmark();
+    return *bench;
+}
+
+static void BM_EKF3_CovariancePrediction(benchmark::State &state)
+{
+    harness().CovariancePrediction(state);
+}
+
+static void BM_EKF3_FuseVelPosNED(benchmark::State &state)
+{
+    harness().FuseVelPosNED(state);
+}
+
+static void BM_EKF3_FuseMagnetometer(benchmark::State &state)
+{
+    harness().FuseMagnetometer(state);
+}
+
+static void BM_EKF3_FuseOptFlow(benchmark::State &state)
+{
+    harness().FuseOptFlow(state);
+}
+
+static void BM_EKF3_calcOutputStates(benchmark::State &state)
+{
+    harness().calcOutputStates(state);
+}
+
+BENCHMARK(BM_EKF3_CovariancePrediction);
+BENCHMARK(BM_EKF3_FuseVelPosNED);
+BENCHMARK(BM_EKF3_FuseMagnetometer);
+BENCHMARK(BM_EKF3_FuseOptFlow);
+BENCHMARK(BM_EKF3_calcOutputStates);
+
+BENCHMARK_MAIN()
@@ -24,6 +24,8 @@
 #include "AP_Param.h"
 
 #include <cmath>
+#include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <AP_Common/AP_Common.h>
@@ -71,6 +73,15 @@ uint16_t AP_Param::_num_vars;
 // cached parameter count
 uint16_t AP_Param::_parameter_count;
 
+// incremented each time the cached parameter count is invalidated
+uint16_t AP_Param::_count_generation;
+
+AP_Param::ParamToken *AP_Param::_index_checkpoints;
+uint16_t AP_Param::_index_checkpoints_size;
+uint16_t AP_Param::_num_index_checkpoints;
+uint16_t AP_Param::_index_checkpoint_generation;
+HAL_Semaphore AP_Param::_index_checkpoint_sem;
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -78,7 +89,15 @@ struct AP_Param::param_override *AP_Param::param_overrides = nullptr;
 uint16_t AP_Param::num_param_overrides = 0;
 uint16_t AP_Param::num_read_only = 0;
 
-ObjectBuffer<AP_Param::param_save> AP_Param::save_queue{30};
+struct AP_Param::save_slots AP_Param::_save;
+HAL_Semaphore AP_Param::_save_sem;
+HAL_Semaphore AP_Param::_save_sync_sem;
+
+struct AP_Param::find_index_entry *AP_Param::_find_index;
+uint16_t AP_Param::_find_index_count;
+uint16_t AP_Param::_find_index_unindexed;
+bool AP_Param::_find_index_failed;
+HAL_Semaphore AP_Param::_find_index_sem;
 bool AP_Param::registered_save_handler;
 
 // we need a dummy object for the parameter save callback
@@ -835,64 +854,330 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 }
 
 
-// Find a variable by name.
-//
-AP_Param *
-AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
+/*
+  check if name is a parameter within _var_info[vindex]. Returns true
+  if it is, with ap set to the parameter or nullptr if the object
+  holding it has not been allocated
+ */
+bool AP_Param::find_in_var(uint16_t vindex, const char *name, enum ap_var_type *ptype, uint16_t *flags, AP_Param *&ap)
 {
-    for (uint16_t i=0; i<_num_vars; i++) {
-        uint8_t type = _var_info[i].type;
+    const struct Info &info = _var_info[vindex];
+    uint8_t type = info.type;
+    if (type == AP_PARAM_GROUP) {
+        uint8_t len = strnlen(info.name, AP_MAX_NAME_SIZE);
+        if (strncmp(name, info.name, len) != 0) {
+            return false;
+        }
+        const struct GroupInfo *group_info = get_group_info(info);
+        if (group_info == nullptr) {
+            return false;
+        }
+        ap = find_group(name + len, vindex, 0, group_info, ptype);
+        if (ap == nullptr) {
+            // we continue looking as we want to allow top level
+            // parameter to have the same prefix name as group
+            // parameters, for example CAM_P_G
+            return false;
+        }
+        if (flags != nullptr) {
+            uint32_t group_element = 0;
+            const struct GroupInfo *ginfo;
+            struct GroupNesting group_nesting {};
+            uint8_t idx;
+            ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
+            if (ginfo != nullptr) {
+                *flags = ginfo->flags;
+            }
+        }
+        return true;
+    }
+    if (strcasecmp(name, info.name) != 0) {
+        return false;
+    }
+    *ptype = (enum ap_var_type)type;
+    ptrdiff_t base;
+    if (!get_base(info, base)) {
+        ap = nullptr;
+    } else {
+        ap = (AP_Param *)base;
+    }
+    return true;
+}
+
+/*
+  continue a case insensitive FNV-1a hash over name. The hash of a
+  full parameter name is built up from its group prefixes
+ */
+uint32_t AP_Param::name_hash(uint32_t hash, const char *name)
+{
+    for (; *name; name++) {
+        hash ^= (uint8_t)toupper(*name);
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static const uint32_t name_hash_basis = 2166136261UL;
+
+static uint16_t name_hash_fold(uint32_t hash)
+{
+    return hash ^ (hash >> 16);
+}
+
+/*
+  add the names within a group to the find() index. With entries
+  nullptr this only counts them
+ */
+void AP_Param::index_group(uint16_t vindex, const struct GroupInfo *group_info, uint32_t hash,
+                           struct find_index_entry *entries, uint16_t &count, bool &complete)
+{
+    uint8_t type;
+    for (uint8_t i=0;
+         (type=group_info[i].type) != AP_PARAM_NONE;
+         i++) {
+        const uint32_t h = name_hash(hash, group_info[i].name);
         if (type == AP_PARAM_GROUP) {
-            uint8_t len = strnlen(_var_info[i].name, AP_MAX_NAME_SIZE);
-            if (strncmp(name, _var_info[i].name, len) != 0) {
+            if (group_info[i].flags & AP_PARAM_FLAG_INFO_POINTER) {
+                // the group_info for this is only known at run time
+                complete = false;
                 continue;
             }
-            const struct GroupInfo *group_info = get_group_info(_var_info[i]);
-            if (group_info == nullptr) {
-                continue;
+            const struct GroupInfo *ginfo = get_group_info(group_info[i]);
+            if (ginfo != nullptr) {
+                index_group(vindex, ginfo, h, entries, count, complete);
             }
-            AP_Param *ap = find_group(name + len, i, 0, group_info, ptype);
-            if (ap != nullptr) {
-                if (flags != nullptr) {
-                    uint32_t group_element = 0;
-                    const struct GroupInfo *ginfo;
-                    struct GroupNesting group_nesting {};
-                    uint8_t idx;
-                    ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
-                    if (ginfo != nullptr) {
-                        *flags = ginfo->flags;
-                    }
+            continue;
+        }
+        uint32_t names[4] = { h };
+        uint8_t num_names = 1;
+        if (type == AP_PARAM_VECTOR3F) {
+            // find_group() also matches the elements of a vector
+            names[num_names++] = name_hash(h, "_X");
+            names[num_names++] = name_hash(h, "_Y");
+            names[num_names++] = name_hash(h, "_Z");
+        }
+        for (uint8_t n=0; n<num_names; n++) {
+            if (entries != nullptr) {
+                entries[count].name_hash = name_hash_fold(names[n]);
+                entries[count].vindex = vindex;
+            }
+            count++;
+        }
+    }
+}
+
+// qsort comparison for the find() index, by name_hash then vindex
+int AP_Param::find_index_compare(const void *v1, const void *v2)
+{
+    const struct find_index_entry *e1 = (const struct find_index_entry *)v1;
+    const struct find_index_entry *e2 = (const struct find_index_entry *)v2;
+    if (e1->name_hash != e2->name_hash) {
+        return e1->name_hash < e2->name_hash ? -1 : 1;
+    }
+    if (e1->vindex != e2->vindex) {
+        return e1->vindex < e2->vindex ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+  build the index used by find(). Returns false if there is not
+  enough memory for it, in which case find() searches every entry
+ */
+bool AP_Param::build_find_index(void)
+{
+    WITH_SEMAPHORE(_find_index_sem);
+
+    if (_find_index != nullptr) {
+        return true;
+    }
+    if (_find_index_failed || _num_vars == 0) {
+        return false;
+    }
+
+    // the first pass counts the entries, the second fills them in
+    struct find_index_entry *entries = nullptr;
+    uint16_t num_hashed = 0;
+    uint16_t count = 0;
+    uint16_t unindexed = 0;
+    for (uint8_t pass=0; pass<2; pass++) {
+        count = 0;
+        unindexed = 0;
+        for (uint16_t i=0; i<_num_vars; i++) {
+            const struct Info &info = _var_info[i];
+            const uint32_t h = name_hash(name_hash_basis, info.name);
+            bool complete = true;
+            if (info.type != AP_PARAM_GROUP) {
+                if (entries != nullptr) {
+                    entries[count].name_hash = name_hash_fold(h);
+                    entries[count].vindex = i;
+                }
+                count++;
+            } else if (info.flags & AP_PARAM_FLAG_INFO_POINTER) {
+                complete = false;
+            } else {
+                const struct GroupInfo *group_info = get_group_info(info);
+                if (group_info != nullptr) {
+                    index_group(i, group_info, h, entries, count, complete);
                 }
-                return ap;
             }
-            // we continue looking as we want to allow top level
-            // parameter to have the same prefix name as group
-            // parameters, for example CAM_P_G
-        } else if (strcasecmp(name, _var_info[i].name) == 0) {
-            *ptype = (enum ap_var_type)type;
-            ptrdiff_t base;
-            if (!get_base(_var_info[i], base)) {
-                return nullptr;
+            if (!complete) {
+                if (entries != nullptr) {
+                    entries[num_hashed+unindexed].vindex = i;
+                }
+                unindexed++;
             }
-            return (AP_Param *)base;
+        }
+        if (pass == 0) {
+            num_hashed = count;
+            const uint32_t size = (num_hashed + unindexed) * sizeof(struct find_index_entry);
+            if (hal.util->available_memory() < size + AP_PARAM_FIND_INDEX_RESERVE) {
+                _find_index_failed = true;
+                return false;
+            }
+            entries = (struct find_index_entry *)calloc(num_hashed + unindexed, sizeof(struct find_index_entry));
+            if (entries == nullptr) {
+                _find_index_failed = true;
+                return false;
+            }
+        }
+    }
+
+    qsort(entries, num_hashed, sizeof(struct find_index_entry), find_index_compare);
+
+    _find_index_count = num_hashed;
+    _find_index_unindexed = unindexed;
+    _find_index = entries;
+    return true;
+}
+
+// Find a variable by name.
+//
+AP_Param *
+AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
+{
+    AP_Param *ap = nullptr;
+
+    if (_find_index == nullptr && !build_find_index()) {
+        for (uint16_t i=0; i<_num_vars; i++) {
+            if (find_in_var(i, name, ptype, flags, ap)) {
+                return ap;
+            }
+        }
+        return nullptr;
+    }
+
+    // find the first entry with this hash
+    const uint16_t hash = name_hash_fold(name_hash(name_hash_basis, name));
+    uint16_t lo = 0;
+    uint16_t hi = _find_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_find_index[mid].name_hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    /*
+      check the candidates together with the unindexed entries in
+      _var_info order, so we return the same match as a full search
+     */
+    const struct find_index_entry *unindexed = &_find_index[_find_index_count];
+    uint16_t u = 0;
+    int32_t last_vindex = -1;
+    while (true) {
+        const bool have_hashed = lo < _find_index_count && _find_index[lo].name_hash == hash;
+        const bool have_unindexed = u < _find_index_unindexed;
+        uint16_t vindex;
+        if (have_hashed && (!have_unindexed || _find_index[lo].vindex <= unindexed[u].vindex)) {
+            vindex = _find_index[lo++].vindex;
+        } else if (have_unindexed) {
+            vindex = unindexed[u++].vindex;
+        } else {
+            break;
+        }
+        if (vindex == last_vindex) {
+            continue;
+        }
+        last_vindex = vindex;
+        if (find_in_var(vindex, name, ptype, flags, ap)) {
+            return ap;
         }
     }
     return nullptr;
 }
 
-// Find a variable by index. Note that this is quite slow.
+/*
+  rebuild the find_by_index() checkpoints if the set of visible
+  parameters may have changed since they were taken. Must be called
+  with _index_checkpoint_sem held
+ */
+void AP_Param::update_index_checkpoints(void)
+{
+    const uint16_t generation = _count_generation;
+    if (_index_checkpoints != nullptr && _index_checkpoint_generation == generation) {
+        return;
+    }
+
+    const uint16_t num = count_parameters() / _index_checkpoint_interval;
+    if (num > _index_checkpoints_size) {
+        free(_index_checkpoints);
+        _index_checkpoints_size = 0;
+        _num_index_checkpoints = 0;
+        _index_checkpoints = (ParamToken *)calloc(num, sizeof(ParamToken));
+        if (_index_checkpoints == nullptr) {
+            // fall back to walking from the first parameter
+            return;
+        }
+        _index_checkpoints_size = num;
+    }
+
+    uint16_t n = 0;
+    uint16_t count = 0;
+    ParamToken token;
+    for (AP_Param *ap = AP_Param::first(&token, nullptr);
+         ap && n < num;
+         ap = AP_Param::next_scalar(&token, nullptr)) {
+        count++;
+        if (count % _index_checkpoint_interval == 0) {
+            _index_checkpoints[n++] = token;
+        }
+    }
+    _num_index_checkpoints = n;
+    _index_checkpoint_generation = generation;
+}
+
+// Find a variable by index, starting from the closest checkpoint
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
-    uint16_t count=0;
-    for (ap=AP_Param::first(token, ptype);
-         ap && count < idx;
-         ap=AP_Param::next_scalar(token, ptype)) {
+    uint16_t count = 0;
+    uint16_t checkpoint = idx / _index_checkpoint_interval;
+    {
+        WITH_SEMAPHORE(_index_checkpoint_sem);
+        update_index_checkpoints();
+        if (checkpoint > _num_index_checkpoints) {
+            checkpoint = _num_index_checkpoints;
+        }
+        if (checkpoint > 0) {
+            *token = _index_checkpoints[checkpoint-1];
+        }
+    }
+    if (checkpoint > 0) {
+        count = checkpoint * _index_checkpoint_interval;
+        ap = AP_Param::next_scalar(token, ptype);
+    } else {
+        ap = AP_Param::first(token, ptype);
+    }
+    while (ap && count < idx) {
+        ap = AP_Param::next_scalar(token, ptype);
         count++;
     }
-    return ap;    
+    return ap;
 }
 
 
@@ -1046,7 +1331,7 @@ void AP_Param::save_sync(bool force_save)
 
     if (phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
         // clear cached parameter count
-        _parameter_count = 0;
+        invalidate_count();
     }
     
     char name[AP_MAX_NAME_SIZE+1];
@@ -1102,27 +1387,140 @@ void AP_Param::save_sync(bool force_save)
 }
 
 /*
-  put variable into queue to be saved
+  hash bucket for a parameter pointer in a table of hash_size entries
+ */
+uint16_t AP_Param::save_hash_bucket(const AP_Param *ap, uint16_t hash_size)
+{
+    uint32_t h = (uint32_t)(uintptr_t)ap;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h & (hash_size - 1);
+}
+
+/*
+  double the number of save slots, with _save_sem held
+ */
+bool AP_Param::save_slots_grow(void)
+{
+    if (_save.size >= AP_PARAM_SAVE_SLOTS_MAX) {
+        return false;
+    }
+    const uint16_t size = _save.size ? _save.size * 2 : 32;
+    const uint16_t hash_size = size * 2;
+    AP_Param **param = (AP_Param **)calloc(size, sizeof(AP_Param *));
+    uint16_t *hash = (uint16_t *)calloc(hash_size, sizeof(uint16_t));
+    uint32_t *dirty = (uint32_t *)calloc(size / 32, sizeof(uint32_t));
+    uint32_t *force = (uint32_t *)calloc(size / 32, sizeof(uint32_t));
+    if (param == nullptr || hash == nullptr || dirty == nullptr || force == nullptr) {
+        free(param);
+        free(hash);
+        free(dirty);
+        free(force);
+        return false;
+    }
+    if (_save.size > 0) {
+        memcpy(param, _save.param, _save.count * sizeof(AP_Param *));
+        memcpy(dirty, _save.dirty, (_save.size / 32) * sizeof(uint32_t));
+        memcpy(force, _save.force, (_save.size / 32) * sizeof(uint32_t));
+    }
+    for (uint16_t i=0; i<_save.count; i++) {
+        uint16_t b = save_hash_bucket(param[i], hash_size);
+        while (hash[b] != 0) {
+            b = (b + 1) & (hash_size - 1);
+        }
+        hash[b] = i + 1;
+    }
+    free(_save.param);
+    free(_save.hash);
+    free(_save.dirty);
+    free(_save.force);
+    _save.param = param;
+    _save.hash = hash;
+    _save.dirty = dirty;
+    _save.force = force;
+    _save.size = size;
+    return true;
+}
+
+/*
+  free the save slots once nothing is pending, with _save_sem held
+ */
+void AP_Param::save_slots_free(void)
+{
+    free(_save.param);
+    free(_save.hash);
+    free(_save.dirty);
+    free(_save.force);
+    memset(&_save, 0, sizeof(_save));
+}
+
+/*
+  mark a parameter as needing to be saved by the IO thread. Returns
+  false if there is no memory for a new slot
+ */
+bool AP_Param::save_mark_dirty(AP_Param *ap, bool force_save)
+{
+    WITH_SEMAPHORE(_save_sem);
+
+    // the hash table is twice the slot capacity, so there is always
+    // an empty entry to stop the probe
+    uint16_t b = 0;
+    uint16_t slot = 0;
+    if (_save.size > 0) {
+        b = save_hash_bucket(ap, _save.size * 2);
+        while (_save.hash[b] != 0 && _save.param[_save.hash[b]-1] != ap) {
+            b = (b + 1) & (_save.size * 2 - 1);
+        }
+        slot = _save.hash[b];
+    }
+    if (slot == 0) {
+        if (_save.count == _save.size) {
+            if (!save_slots_grow()) {
+                return false;
+            }
+            b = save_hash_bucket(ap, _save.size * 2);
+            while (_save.hash[b] != 0) {
+                b = (b + 1) & (_save.size * 2 - 1);
+            }
+        }
+        _save.param[_save.count++] = ap;
+        _save.hash[b] = _save.count;
+        slot = _save.count;
+    }
+    slot--;
+
+    const uint32_t mask = 1U << (slot % 32);
+    if ((_save.dirty[slot / 32] & mask) == 0) {
+        _save.dirty[slot / 32] |= mask;
+        _save.pending++;
+    }
+    if (force_save) {
+        _save.force[slot / 32] |= mask;
+    }
+    return true;
+}
+
+/*
+  mark variable to be saved by the IO thread
 */
 void AP_Param::save(bool force_save)
 {
-    struct param_save p;
-    p.param = this;
-    p.force_save = force_save;
-    while (!save_queue.push(p)) {
-        // if we can't save to the queue
-        if (hal.util->get_soft_armed()) {
-            // if we are armed then don't sleep, instead we lose the
-            // parameter save
-            return;
-        }
-        // when we are disarmed then loop waiting for a slot to become
-        // available. This guarantees completion for large parameter
-        // set loads
-        hal.scheduler->expect_delay_ms(1);
-        hal.scheduler->delay_microseconds(500);
-        hal.scheduler->expect_delay_ms(0);
+    if (save_mark_dirty(this, force_save)) {
+        return;
+    }
+    // we are out of memory for a new save slot
+    if (hal.util->get_soft_armed()) {
+        // if we are armed then don't wait for the IO thread, instead
+        // we lose the parameter save
+        return;
     }
+    // when disarmed let the IO thread finish what it has and save
+    // this one directly. This guarantees completion for large
+    // parameter set loads
+    flush();
+    WITH_SEMAPHORE(_save_sync_sem);
+    save_sync(force_save);
 }
 
 /*
@@ -1130,9 +1528,37 @@ void AP_Param::save(bool force_save)
  */
 void AP_Param::save_io_handler(void)
 {
-    struct param_save p;
-    while (save_queue.pop(p)) {
-        p.param->save_sync(p.force_save);
+    for (uint16_t w=0; ; w++) {
+        uint32_t dirty, force;
+        {
+            WITH_SEMAPHORE(_save_sem);
+            if (_save.pending == 0 && _save.size > 0) {
+                save_slots_free();
+            }
+            if (_save.pending == 0 || w >= _save.size / 32) {
+                return;
+            }
+            dirty = _save.dirty[w];
+            force = _save.force[w];
+            _save.dirty[w] = 0;
+            _save.force[w] &= ~dirty;
+        }
+        while (dirty != 0) {
+            const uint8_t bit = __builtin_ctz(dirty);
+            dirty &= dirty - 1;
+            AP_Param *ap;
+            {
+                // the slot table may be reallocated by save()
+                WITH_SEMAPHORE(_save_sem);
+                ap = _save.param[w*32 + bit];
+            }
+            {
+                WITH_SEMAPHORE(_save_sync_sem);
+                ap->save_sync((force & (1U << bit)) != 0);
+            }
+            WITH_SEMAPHORE(_save_sem);
+            _save.pending--;
+        }
     }
 }
 
@@ -1142,7 +1568,7 @@ void AP_Param::save_io_handler(void)
 void AP_Param::flush(void)
 {
     uint16_t counter = 200; // 2 seconds max
-    while (counter-- && save_queue.available()) {
+    while (counter-- && _save.pending != 0) {
         hal.scheduler->expect_delay_ms(10);
         hal.scheduler->delay(10);
         hal.scheduler->expect_delay_ms(0);
@@ -1244,6 +1670,21 @@ bool AP_Param::configured_in_storage(void) const
     return scan(&phdr, &ofs) && (phdr.type == AP_PARAM_VECTOR3F || idx == 0);
 }
 
+bool AP_Param::get_token_default(const ParamToken &token, float &value) const
+{
+    uint32_t group_element;
+    const struct GroupInfo *ginfo;
+    struct GroupNesting group_nesting {};
+    uint8_t idx;
+    const struct AP_Param::Info *info = find_var_info_token(token, &group_element, ginfo, group_nesting, &idx);
+    if (info == nullptr) {
+        return false;
+    }
+    // the elements of a vector share the default of the vector
+    value = get_default_value(this, ginfo != nullptr ? &ginfo->def_value : &info->def_value);
+    return true;
+}
+
 bool AP_Param::configured_in_defaults_file(bool &read_only) const
 {
     if (num_param_overrides == 0) {
@@ -1448,7 +1889,7 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
     uint16_t key;
 
     // reset cached param counter as we may be loading a dynamic var_info
-    _parameter_count = 0;
+    invalidate_count();
     
     if (!find_key_by_pointer(object_pointer, key)) {
         hal.console->printf("ERROR: Unable to find param pointer\n");
@@ -2230,6 +2671,12 @@ void AP_Param::send_parameter(const char *name, enum ap_var_type var_type, uint8
 #endif // HAL_NO_GCS
 }
 
+void AP_Param::invalidate_count(void)
+{
+    _parameter_count = 0;
+    _count_generation++;
+}
+
 /*
   return count of all scalar parameters.
   Note that this function may be called from the IO thread, so needs
@@ -42,6 +42,18 @@
 #define AP_PARAM_MAX_EMBEDDED_PARAM 8192
 #endif
 
+// free memory that must be left after allocating the find() name
+// index. Boards with less than this search the parameter tables instead
+#ifndef AP_PARAM_FIND_INDEX_RESERVE
+#define AP_PARAM_FIND_INDEX_RESERVE 16384
+#endif
+
+// maximum number of parameters with a background save pending. A
+// power of two no larger than 16384
+#ifndef AP_PARAM_SAVE_SLOTS_MAX
+#define AP_PARAM_SAVE_SLOTS_MAX 2048
+#endif
+
 /*
   flags for variables in var_info and group tables
  */
@@ -431,6 +443,10 @@ public:
     // return true if the parameter is configured in EEPROM/FRAM
     bool configured_in_storage(void) const;
 
+    // get the default value of this parameter, using the token it was
+    // found with. This includes any override from a defaults file
+    bool get_token_default(const ParamToken &token, float &value) const;
+
     // return true if the parameter is configured
     bool configured(void) const;
 
@@ -440,11 +456,15 @@ public:
     // count of parameters in tree
     static uint16_t count_parameters(void);
 
-    static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
+    static void set_hide_disabled_groups(bool value) {
+        _hide_disabled_groups = value;
+        invalidate_count();
+    }
 
     // set frame type flags. Used to unhide frame specific parameters
     static void set_frame_type_flags(uint16_t flags_to_set) {
         _frame_type_flags |= flags_to_set;
+        invalidate_count();
     }
 
     // check if a given frame type should be included
@@ -579,6 +599,12 @@ private:
                                     ptrdiff_t group_offset,
                                     const struct GroupInfo *group_info,
                                     enum ap_var_type *ptype);
+    static bool                 find_in_var(
+                                    uint16_t vindex,
+                                    const char *name,
+                                    enum ap_var_type *ptype,
+                                    uint16_t *flags,
+                                    AP_Param *&ap);
     static void                 write_sentinal(uint16_t ofs);
     static uint16_t             get_key(const Param_header &phdr);
     static void                 set_key(Param_header &phdr, uint16_t key);
@@ -624,9 +650,52 @@ private:
     // send a parameter to all GCS instances
     void send_parameter(const char *name, enum ap_var_type param_header_type, uint8_t idx) const;
 
+    /*
+      index used by find(). Each name a _var_info entry can match is
+      hashed, and the hashes are kept sorted so find() only needs to
+      check the entries whose hash matches. Entries containing groups
+      with a run-time group_info pointer can't be listed up front, so
+      they are kept after the sorted part and always checked
+     */
+    struct find_index_entry {
+        uint16_t name_hash;
+        uint16_t vindex;
+    };
+    static struct find_index_entry *_find_index;
+    static uint16_t _find_index_count;      // sorted hash entries
+    static uint16_t _find_index_unindexed;  // always checked entries following them
+    static bool _find_index_failed;
+    static HAL_Semaphore _find_index_sem;
+
+    static uint32_t name_hash(uint32_t hash, const char *name);
+    static void index_group(uint16_t vindex, const struct GroupInfo *group_info, uint32_t hash,
+                            struct find_index_entry *entries, uint16_t &count, bool &complete);
+    static bool build_find_index(void);
+    static int find_index_compare(const void *v1, const void *v2);
+
+    /*
+      tokens for every _index_checkpoint_interval'th scalar parameter,
+      so find_by_index() does not have to walk from the first
+      parameter. Entry n is the token next_scalar() leaves after
+      returning parameter (n+1)*_index_checkpoint_interval-1. The
+      table is rebuilt when the parameter count is invalidated
+     */
+    static const uint8_t _index_checkpoint_interval = 32;
+    static ParamToken *_index_checkpoints;
+    static uint16_t _index_checkpoints_size;
+    static uint16_t _num_index_checkpoints;
+    static uint16_t _index_checkpoint_generation;
+    static HAL_Semaphore _index_checkpoint_sem;
+    static void update_index_checkpoints(void);
+
+    // forget the cached parameter count, eg. after an enable
+    // parameter changed which parameters are visible
+    static void invalidate_count(void);
+
     static StorageAccess        _storage;
     static uint16_t             _num_vars;
     static uint16_t             _parameter_count;
+    static uint16_t             _count_generation;
     static const struct Info *  _var_info;
 
     /*
@@ -648,13 +717,32 @@ private:
 
     static bool _hide_disabled_groups;
 
-    // support for background saving of parameters. We pack it to reduce memory for the
-    // queue
-    struct PACKED param_save {
-        AP_Param *param;
-        bool force_save;
+    /*
+      support for background saving of parameters. Each parameter that
+      has been saved gets a slot the first time, and a pending save is
+      a bit in the dirty bitmap for its slot. Saving the same parameter
+      again before the IO thread gets to it costs nothing, and the
+      tables grow as needed so save() never has to wait for room. The
+      tables are freed once the IO thread has saved everything
+     */
+    struct save_slots {
+        AP_Param **param;       // parameter for each slot
+        uint16_t *hash;         // open addressed slot+1 by pointer, 0 if empty
+        uint32_t *dirty;        // bitmap of slots waiting to be saved
+        uint32_t *force;        // bitmap of slots saved with force_save
+        uint16_t count;
+        uint16_t size;          // capacity, a multiple of 32
+        uint16_t pending;       // saves queued or in progress
     };
-    static ObjectBuffer<struct param_save> save_queue;
+    static struct save_slots _save;
+    static HAL_Semaphore _save_sem;
+    // held while the IO thread or a save() that found no free slot
+    // writes a parameter to storage
+    static HAL_Semaphore _save_sync_sem;
+    static bool save_mark_dirty(AP_Param *ap, bool force_save);
+    static bool save_slots_grow(void);
+    static void save_slots_free(void);
+    static uint16_t save_hash_bucket(const AP_Param *ap, uint16_t hash_size);
     static bool registered_save_handler;
 
     // background function for saving parameters
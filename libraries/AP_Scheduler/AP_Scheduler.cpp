@@ -57,6 +57,13 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("LOOP_RATE",  1, AP_Scheduler, _loop_rate_hz, SCHEDULER_DEFAULT_LOOP_RATE),
 
+    // @Param: OPTIONS
+    // @DisplayName: Scheduling options
+    // @Description: Scheduling options. EarliestDeadlineFirst runs due tasks in order of how overdue they are relative to their rate, rather than in table order, and fits them into the remaining loop time using each task's measured execution time rather than its table time limit.
+    // @Bitmask: 0:EarliestDeadlineFirst
+    // @User: Advanced
+    AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
+
     AP_GROUPEND
 };
 
@@ -99,6 +106,16 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
     _num_tasks = num_tasks;
     _last_run = new uint16_t[_num_tasks];
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
+    _task_stats = new TaskStats[_num_tasks];
+    if (_task_stats != nullptr) {
+        memset(_task_stats, 0, sizeof(_task_stats[0]) * _num_tasks);
+    }
+    _task_time_est = new uint16_t[_num_tasks];
+    if (_task_time_est != nullptr) {
+        memset(_task_time_est, 0, sizeof(_task_time_est[0]) * _num_tasks);
+    }
+    _edf_order = new uint8_t[_num_tasks];
+    _edf_key = new uint32_t[_num_tasks];
     _tick_counter = 0;
 
     // setup initial performance counters
@@ -143,80 +160,49 @@ void AP_Scheduler::run(uint32_t time_available)
             }
         }
     }
-    
+
+    const bool edf = (_options & uint8_t(Options::EARLIEST_DEADLINE_FIRST)) &&
+        _edf_order != nullptr && _edf_key != nullptr && _task_time_est != nullptr;
+    uint8_t num_ready = 0;
+
     for (uint8_t i=0; i<_num_tasks; i++) {
-        uint32_t dt = _tick_counter - _last_run[i];
-        uint32_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
-        if (interval_ticks < 1) {
-            interval_ticks = 1;
-        }
-        if (dt < interval_ticks) {
-            // this task is not yet scheduled to run again
+        uint16_t dt;
+        uint32_t interval_ticks;
+        if (!task_due(i, dt, interval_ticks)) {
             continue;
         }
-        // this task is due to run. Do we have enough time to run it?
-        _task_time_allowed = _tasks[i].max_time_micros;
-
-        if (dt >= interval_ticks*2) {
-            // we've slipped a whole run of this task!
-            debug(2, "Scheduler slip task[%u-%s] (%u/%u/%u)\n",
-                  (unsigned)i,
-                  _tasks[i].name,
-                  (unsigned)dt,
-                  (unsigned)interval_ticks,
-                  (unsigned)_task_time_allowed);
-        }
-
-        if (dt >= interval_ticks*max_task_slowdown) {
-            // we are going beyond the maximum slowdown factor for a
-            // task. This will trigger increasing the time budget
-            task_not_achieved++;
-        }
 
-        if (_task_time_allowed > time_available) {
-            // not enough time to run this task.  Continue loop -
-            // maybe another task will fit into time remaining
+        if (!edf) {
+            if (!run_task(i, dt, interval_ticks, false, time_available, now)) {
+                break;
+            }
             continue;
         }
 
-        // run it
-        _task_time_started = now;
-        hal.util->persistent_data.scheduler_task = i;
-        if (_debug > 1 && _perf_counters && _perf_counters[i]) {
-            hal.util->perf_begin(_perf_counters[i]);
-        }
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        fill_nanf_stack();
-#endif
-        _tasks[i].function();
-        if (_debug > 1 && _perf_counters && _perf_counters[i]) {
-            hal.util->perf_end(_perf_counters[i]);
+        // insert into the run order by how many of its periods the
+        // task is overdue, keeping table order between equals
+        const uint32_t overdue = uint32_t(dt) * 256 / interval_ticks;
+        uint8_t pos = num_ready;
+        while (pos > 0 && _edf_key[pos-1] < overdue) {
+            _edf_order[pos] = _edf_order[pos-1];
+            _edf_key[pos] = _edf_key[pos-1];
+            pos--;
         }
-        hal.util->persistent_data.scheduler_task = -1;
+        _edf_order[pos] = i;
+        _edf_key[pos] = overdue;
+        num_ready++;
+    }
 
-        // record the tick counter when we ran. This drives
-        // when we next run the event
-        _last_run[i] = _tick_counter;
-
-        // work out how long the event actually took
-        now = AP_HAL::micros();
-        uint32_t time_taken = now - _task_time_started;
-
-        if (time_taken > _task_time_allowed) {
-            // the event overran!
-            debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
-                  (unsigned)i,
-                  _tasks[i].name,
-                  (unsigned)time_taken,
-                  (unsigned)_task_time_allowed);
-        }
-        if (time_taken >= time_available) {
-            time_available = 0;
+    for (uint8_t n=0; n<num_ready; n++) {
+        const uint8_t i = _edf_order[n];
+        const uint16_t dt = _tick_counter - _last_run[i];
+        if (!run_task(i, dt, task_interval_ticks(i), true, time_available, now)) {
             break;
         }
-        time_available -= time_taken;
     }
 
+    update_missed_tasks();
+
     // update number of spare microseconds
     _spare_micros += time_available;
 
@@ -227,6 +213,212 @@ void AP_Scheduler::run(uint32_t time_available)
     }
 }
 
+// number of ticks between runs of task i
+uint32_t AP_Scheduler::task_interval_ticks(uint8_t i) const
+{
+    uint32_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
+    if (interval_ticks < 1) {
+        interval_ticks = 1;
+    }
+    return interval_ticks;
+}
+
+/*
+  return true if task i is due to run, with the ticks since it last
+  ran and between its runs
+ */
+bool AP_Scheduler::task_due(uint8_t i, uint16_t &dt, uint32_t &interval_ticks)
+{
+    // subtract in 16 bits so this is right across a tick counter wrap
+    dt = _tick_counter - _last_run[i];
+    interval_ticks = task_interval_ticks(i);
+    if (dt < interval_ticks) {
+        // this task is not yet scheduled to run again
+        return false;
+    }
+
+    if (dt >= interval_ticks*2) {
+        // we've slipped a whole run of this task!
+        debug(2, "Scheduler slip task[%u-%s] (%u/%u/%u)\n",
+              (unsigned)i,
+              _tasks[i].name,
+              (unsigned)dt,
+              (unsigned)interval_ticks,
+              (unsigned)_tasks[i].max_time_micros);
+    }
+
+    if (dt >= interval_ticks*max_task_slowdown) {
+        // we are going beyond the maximum slowdown factor for a
+        // task. This will trigger increasing the time budget
+        task_not_achieved++;
+    }
+
+    return true;
+}
+
+/*
+  run task i if it fits in time_available, which is reduced by the
+  time it took. The task is fitted using its learned execution time
+  if use_estimate is set, else its max_time_micros. Returns false
+  once there is no time left
+ */
+bool AP_Scheduler::run_task(uint8_t i, uint16_t dt, uint32_t interval_ticks, bool use_estimate,
+                            uint32_t &time_available, uint32_t &now)
+{
+    // this task is due to run. Do we have enough time to run it?
+    _task_time_allowed = _tasks[i].max_time_micros;
+
+    uint32_t time_needed = _task_time_allowed;
+    if (use_estimate && _task_time_est[i] != 0) {
+        time_needed = _task_time_est[i];
+    }
+    if (time_needed > time_available) {
+        // not enough time to run this task.  Continue loop -
+        // maybe another task will fit into time remaining
+        return true;
+    }
+
+    // run it
+    _task_time_started = now;
+    hal.util->persistent_data.scheduler_task = i;
+    if (_debug > 1 && _perf_counters && _perf_counters[i]) {
+        hal.util->perf_begin(_perf_counters[i]);
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    fill_nanf_stack();
+#endif
+    _tasks[i].function();
+    if (_debug > 1 && _perf_counters && _perf_counters[i]) {
+        hal.util->perf_end(_perf_counters[i]);
+    }
+    hal.util->persistent_data.scheduler_task = -1;
+
+    // record the tick counter when we ran. This drives
+    // when we next run the event
+    _last_run[i] = _tick_counter;
+
+    // work out how long the event actually took
+    now = AP_HAL::micros();
+    uint32_t time_taken = now - _task_time_started;
+
+    update_task_stats(i, _task_time_started, time_taken, dt, interval_ticks);
+
+    if (_task_time_est != nullptr) {
+        // follow a longer run straight away and a shorter one slowly,
+        // so the estimate stays near the task's worst recent time
+        uint16_t &est = _task_time_est[i];
+        const uint16_t t = MIN(time_taken, (uint32_t)_tasks[i].max_time_micros);
+        if (t >= est) {
+            est = t;
+        } else {
+            est -= (est - t + 15) / 16;
+        }
+    }
+
+    if (time_taken > _task_time_allowed) {
+        // the event overran!
+        debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
+              (unsigned)i,
+              _tasks[i].name,
+              (unsigned)time_taken,
+              (unsigned)_task_time_allowed);
+    }
+    if (time_taken >= time_available) {
+        time_available = 0;
+        return false;
+    }
+    time_available -= time_taken;
+    return true;
+}
+
+const uint16_t AP_Scheduler::task_exec_hist_bounds_us[AP_SCHEDULER_TASK_EXEC_HIST_BUCKETS-1] = {
+    50, 100, 200, 500, 1000, 2000, 5000
+};
+
+/*
+  record a run of task i, which was due interval_ticks after its last
+  run and started dt ticks after it
+ */
+void AP_Scheduler::update_task_stats(uint8_t i, uint32_t start_us, uint32_t time_taken,
+                                     uint16_t dt, uint32_t interval_ticks)
+{
+    if (_task_stats == nullptr) {
+        return;
+    }
+    TaskStats &st = _task_stats[i];
+
+    uint8_t b = 0;
+    while (b < ARRAY_SIZE(task_exec_hist_bounds_us) && time_taken >= task_exec_hist_bounds_us[b]) {
+        b++;
+    }
+    if (st.exec_hist[b] < UINT16_MAX) {
+        st.exec_hist[b]++;
+    }
+    if (st.runs < UINT16_MAX) {
+        st.runs++;
+    }
+    if (dt >= interval_ticks*2 && st.slips < UINT16_MAX) {
+        st.slips++;
+    }
+    if (time_taken > _tasks[i].max_time_micros && st.overruns < UINT16_MAX) {
+        st.overruns++;
+    }
+    st.max_time_us = MAX(st.max_time_us, MIN(time_taken, (uint32_t)UINT16_MAX));
+    st.sum_time_us += time_taken;
+
+    if (st.last_start_us != 0) {
+        const int32_t period_us = start_us - st.last_start_us;
+        const int32_t jitter_us = abs(period_us - int32_t(interval_ticks * get_loop_period_us()));
+        st.max_jitter_us = MAX(st.max_jitter_us, MIN(uint32_t(jitter_us), (uint32_t)UINT16_MAX));
+        st.sum_jitter_us += jitter_us;
+        if (st.jitter_samples < UINT16_MAX) {
+            st.jitter_samples++;
+        }
+    }
+    st.last_start_us = start_us;
+}
+
+/*
+  count a miss for each task that is still due at the end of run(),
+  either as there was no time left or as it didn't fit, so tasks
+  being starved show up in the statistics even if they never run
+ */
+void AP_Scheduler::update_missed_tasks(void)
+{
+    if (_task_stats == nullptr) {
+        return;
+    }
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const uint16_t dt = _tick_counter - _last_run[i];
+        TaskStats &st = _task_stats[i];
+        if (dt >= task_interval_ticks(i) && st.missed < UINT16_MAX) {
+            st.missed++;
+        }
+    }
+}
+
+/*
+  return the upper bound of the histogram bucket holding the given
+  percentile of a task's execution times, or its maximum if that is
+  the last bucket
+ */
+uint16_t AP_Scheduler::task_percentile_us(const TaskStats &st, uint8_t percent)
+{
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < AP_SCHEDULER_TASK_EXEC_HIST_BUCKETS; b++) {
+        total += st.exec_hist[b];
+    }
+    const uint32_t threshold = (total * percent + 99) / 100;
+    uint32_t sum = 0;
+    for (uint8_t b = 0; b < ARRAY_SIZE(task_exec_hist_bounds_us); b++) {
+        sum += st.exec_hist[b];
+        if (sum >= threshold) {
+            return MIN(task_exec_hist_bounds_us[b], st.max_time_us);
+        }
+    }
+    return st.max_time_us;
+}
+
 /*
   return number of micros until the current task reaches its deadline
  */
@@ -345,6 +537,16 @@ void AP_Scheduler::update_logging()
     if (_log_performance_bit != (uint32_t)-1 &&
         AP::logger().should_log(_log_performance_bit)) {
         Log_Write_Performance();
+        Log_Write_TimingStats();
+        Log_Write_TaskStats();
+    }
+    if (_task_stats != nullptr) {
+        // keep the time of each task's last start for its next jitter
+        for (uint8_t i = 0; i < _num_tasks; i++) {
+            const uint32_t last_start_us = _task_stats[i].last_start_us;
+            memset(&_task_stats[i], 0, sizeof(_task_stats[i]));
+            _task_stats[i].last_start_us = last_start_us;
+        }
     }
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
@@ -372,6 +574,91 @@ void AP_Scheduler::Log_Write_Performance()
     AP::logger().WriteCriticalBlock(&pkt, sizeof(pkt));
 }
 
+/*
+  write the tasks doing worst since the last update_logging(), ranked
+  by misses plus slips plus overruns and then by longest run, so tasks
+  starving others show up alongside the tasks being starved, including
+  ones that never got to run
+ */
+void AP_Scheduler::Log_Write_TaskStats()
+{
+    if (_task_stats == nullptr) {
+        return;
+    }
+
+    // insertion sort the worst few task indexes
+    uint8_t worst[AP_SCHEDULER_LOG_WORST_TASKS];
+    uint8_t num_worst = 0;
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const TaskStats &st = _task_stats[i];
+        if (st.runs == 0 && st.missed == 0) {
+            continue;
+        }
+        uint8_t pos = num_worst;
+        while (pos > 0) {
+            const TaskStats &other = _task_stats[worst[pos-1]];
+            const uint32_t misses = st.missed + st.slips + st.overruns;
+            const uint32_t other_misses = other.missed + other.slips + other.overruns;
+            if (misses < other_misses ||
+                (misses == other_misses && st.max_time_us <= other.max_time_us)) {
+                break;
+            }
+            if (pos < AP_SCHEDULER_LOG_WORST_TASKS) {
+                worst[pos] = worst[pos-1];
+            }
+            pos--;
+        }
+        if (pos < AP_SCHEDULER_LOG_WORST_TASKS) {
+            worst[pos] = i;
+            num_worst = MIN(num_worst+1, AP_SCHEDULER_LOG_WORST_TASKS);
+        }
+    }
+
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t n = 0; n < num_worst; n++) {
+        const uint8_t i = worst[n];
+        const TaskStats &st = _task_stats[i];
+        char name[16] {};
+        strncpy(name, _tasks[i].name, sizeof(name)-1);
+        AP::logger().Write("STSK", "TimeUS,N,Name,Runs,Miss,Slip,Over,AvgT,MaxT,P95T,AvgJ,MaxJ",
+                           "s------sssss", "F------FFFFF", "QBNHHHHHHHHH",
+                           now,
+                           n,
+                           name,
+                           st.runs,
+                           st.missed,
+                           st.slips,
+                           st.overruns,
+                           (uint16_t)(st.runs ? st.sum_time_us / st.runs : 0),
+                           st.max_time_us,
+                           task_percentile_us(st, 95),
+                           (uint16_t)(st.jitter_samples ? MIN(st.sum_jitter_us / st.jitter_samples, (uint32_t)UINT16_MAX) : 0),
+                           st.max_jitter_us);
+    }
+}
+
+/*
+  write the execution time statistics the HAL keeps for its threads
+  and callbacks. Values are since boot, in microseconds
+ */
+void AP_Scheduler::Log_Write_TimingStats()
+{
+    AP_HAL::Util::TimingStats stats;
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t i = 0; hal.util->get_timing_stats(i, stats); i++) {
+        AP::logger().Write("HTIM", "TimeUS,Name,Count,Min,Mean,Max,P99,Over",
+                           "s--ssss-", "F--FFFF-", "QNIIIIII",
+                           now,
+                           stats.name,
+                           stats.count,
+                           stats.min_us,
+                           stats.mean_us,
+                           stats.max_us,
+                           stats.p99_us,
+                           stats.overruns);
+    }
+}
+
 namespace AP {
 
 AP_Scheduler &scheduler()
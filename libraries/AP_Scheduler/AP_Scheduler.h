@@ -27,6 +27,12 @@
 
 #define AP_SCHEDULER_NAME_INITIALIZER(_name) .name = #_name,
 
+// number of buckets in each task's execution time histogram
+#define AP_SCHEDULER_TASK_EXEC_HIST_BUCKETS 8
+
+// number of tasks listed in the STSK message each logging interval
+#define AP_SCHEDULER_LOG_WORST_TASKS 5
+
 /*
   useful macro for creating scheduler task table
  */
@@ -87,6 +93,40 @@ public:
     // write out PERF message to logger
     void Log_Write_Performance();
 
+    // write out an HTIM message for each HAL timing histogram
+    void Log_Write_TimingStats();
+
+    // write out STSK messages for the tasks doing worst this interval
+    void Log_Write_TaskStats();
+
+    /*
+      per-task statistics, reset at each update_logging(). Execution
+      times are in microseconds. Jitter is how far the time between
+      two starts of the task was from its scheduled period. A task is
+      counted as missed on each tick it was due but not run
+     */
+    struct TaskStats {
+        uint16_t exec_hist[AP_SCHEDULER_TASK_EXEC_HIST_BUCKETS]; // execution time counts
+        uint16_t runs;
+        uint16_t missed;        // ticks it was due but not run
+        uint16_t slips;         // times a whole run was missed
+        uint16_t overruns;      // runs longer than max_time_micros
+        uint16_t max_time_us;
+        uint32_t sum_time_us;
+        uint16_t max_jitter_us;
+        uint32_t sum_jitter_us;
+        uint16_t jitter_samples; // runs with a previous start to compare
+        uint32_t last_start_us;
+    };
+
+    // get the statistics for task i, or nullptr if there are none
+    const TaskStats *get_task_stats(uint8_t i) const {
+        return (_task_stats != nullptr && i < _num_tasks) ? &_task_stats[i] : nullptr;
+    }
+
+    // upper bound in microseconds of each histogram bucket but the last
+    static const uint16_t task_exec_hist_bounds_us[AP_SCHEDULER_TASK_EXEC_HIST_BUCKETS-1];
+
     // call when one tick has passed
     void tick(void);
 
@@ -147,6 +187,11 @@ public:
 
     static const struct AP_Param::GroupInfo var_info[];
 
+    // bits in SCHED_OPTIONS
+    enum class Options : uint8_t {
+        EARLIEST_DEADLINE_FIRST = (1U << 0),
+    };
+
     // loop performance monitoring:
     AP::PerfInfo perf_info;
 
@@ -160,6 +205,9 @@ private:
     // overall scheduling rate in Hz
     AP_Int16 _loop_rate_hz;
 
+    // bitmask of Options
+    AP_Int8 _options;
+
     // loop rate in Hz as set at startup
     AP_Int16 _active_loop_rate_hz;
     
@@ -182,6 +230,29 @@ private:
     // tick counter at the time we last ran each task
     uint16_t *_last_run;
 
+    // statistics for each task, same size as _last_run
+    TaskStats *_task_stats;
+
+    // learned execution time of each task in microseconds, never
+    // above its max_time_micros. Zero until the task has run
+    uint16_t *_task_time_est;
+
+    // task indexes in the order they are run in earliest deadline
+    // first mode, and how overdue each one is in 1/256ths of its
+    // period
+    uint8_t *_edf_order;
+    uint32_t *_edf_key;
+
+    uint32_t task_interval_ticks(uint8_t i) const;
+    bool task_due(uint8_t i, uint16_t &dt, uint32_t &interval_ticks);
+    bool run_task(uint8_t i, uint16_t dt, uint32_t interval_ticks, bool use_estimate,
+                  uint32_t &time_available, uint32_t &now);
+
+    void update_task_stats(uint8_t i, uint32_t start_us, uint32_t time_taken,
+                           uint16_t dt, uint32_t interval_ticks);
+    void update_missed_tasks(void);
+    static uint16_t task_percentile_us(const TaskStats &st, uint8_t percent);
+
     // number of microseconds allowed for the current task
     uint32_t _task_time_allowed;
 
@@ -41,12 +41,20 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: SPACING
     // @DisplayName: Terrain grid spacing
-    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in the vehicle keeping 12 grid squares in memory with each grid square having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
+    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in each grid square held in memory (see TERRAIN_CACHE_SZ) having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
     // @Units: m
     // @Increment: 1
     // @User: Advanced
     AP_GROUPINFO("SPACING",   1, AP_Terrain, grid_spacing, 100),
 
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: The number of terrain grid squares to keep in memory. Each one takes a little over 2 kilobytes. With 32 or more the vehicle also loads the grid squares ahead of it along its flight path and the upcoming mission legs before they are needed.
+    // @Range: 4 4096
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  2, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
+
     AP_GROUPEND
 };
 
@@ -101,6 +109,32 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     // find the grid
     const struct grid_block &grid = find_grid_cache(info).grid;
 
+    if (!interpolate_height(grid, info, height)) {
+        return false;
+    }
+
+    if (loc.lat == ahrs.get_home().lat &&
+        loc.lng == ahrs.get_home().lng) {
+        // remember home altitude as a special case
+        home_height = height;
+        home_loc = loc;
+    }
+
+    // apply correction which assumes home altitude is at terrain altitude
+    if (corrected) {
+        height += (ahrs.get_home().alt * 0.01f) - home_height;
+    }
+
+    return true;
+}
+
+
+/*
+  interpolate the height at a grid_info from its grid block. Returns
+  false if the block doesn't have all four surrounding heights
+ */
+bool AP_Terrain::interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height)
+{
     /*
       note that we rely on the one square overlap to ensure these
       calculations don't go past the end of the arrays
@@ -133,22 +167,122 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     float avg  = (1.0f-info.frac_y) * avg1 + info.frac_y * avg2;
 
     height = avg;
+    return true;
+}
 
-    if (loc.lat == ahrs.get_home().lat &&
-        loc.lng == ahrs.get_home().lng) {
-        // remember home altitude as a special case
-        home_height = height;
-        home_loc = loc;
+/*
+  uncorrected height for one location of a batch query, reusing the
+  grid block of the previous location when it is the same one
+ */
+bool AP_Terrain::height_amsl_batch(const Location &loc, struct grid_cache *&gcache, float &height,
+                                   MissingBlocks *missing)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+
+    if (gcache == nullptr ||
+        gcache->grid.lat != info.grid_lat ||
+        gcache->grid.lon != info.grid_lon ||
+        gcache->grid.spacing != grid_spacing) {
+        gcache = &find_grid_cache(info);
     }
 
-    // apply correction which assumes home altitude is at terrain altitude
-    if (corrected) {
-        height += (ahrs.get_home().alt * 0.01f) - home_height;
+    if (interpolate_height(gcache->grid, info, height)) {
+        return true;
     }
 
-    return true;
+    if (missing != nullptr) {
+        for (uint8_t i=0; i<missing->count; i++) {
+            if (missing->corner[i].lat == info.grid_lat &&
+                missing->corner[i].lng == info.grid_lon) {
+                return false;
+            }
+        }
+        if (missing->count < MissingBlocks::max_blocks) {
+            Location &corner = missing->corner[missing->count++];
+            corner.zero();
+            corner.lat = info.grid_lat;
+            corner.lng = info.grid_lon;
+        } else {
+            missing->overflow = true;
+        }
+    }
+    return false;
 }
 
+/*
+  find the terrain heights of a set of locations in one pass
+ */
+uint16_t AP_Terrain::height_amsl(const Location *locs, uint16_t count, float *heights,
+                                 MissingBlocks *missing)
+{
+    if (missing != nullptr) {
+        missing->count = 0;
+        missing->overflow = false;
+    }
+    if (!allocate() || grid_spacing <= 0) {
+        for (uint16_t i=0; i<count; i++) {
+            heights[i] = NAN;
+        }
+        return 0;
+    }
+
+    struct grid_cache *gcache = nullptr;
+    uint16_t found = 0;
+    for (uint16_t i=0; i<count; i++) {
+        if (height_amsl_batch(locs[i], gcache, heights[i], missing)) {
+            found++;
+        } else {
+            heights[i] = NAN;
+        }
+    }
+    return found;
+}
+
+/*
+  sample terrain heights along a polyline
+ */
+uint16_t AP_Terrain::height_amsl_path(const Location *points, uint16_t num_points, float spacing,
+                                      float *heights, uint16_t max_heights,
+                                      MissingBlocks *missing)
+{
+    if (missing != nullptr) {
+        missing->count = 0;
+        missing->overflow = false;
+    }
+    if (num_points == 0 || max_heights == 0 || !is_positive(spacing)) {
+        return 0;
+    }
+    const bool available = allocate() && grid_spacing > 0;
+
+    struct grid_cache *gcache = nullptr;
+    uint16_t n = 0;
+
+    // distance along the current leg of the next sample
+    float next = 0;
+    for (uint16_t i=0; i+1<num_points && n<max_heights; i++) {
+        const Location &from = points[i];
+        const Location &to = points[i+1];
+        const float length = from.get_distance(to);
+        const float bearing = from.get_bearing_to(to) * 0.01f;
+        for (; next < length && n < max_heights; next += spacing) {
+            Location loc = from;
+            loc.offset_bearing(bearing, next);
+            if (!available || !height_amsl_batch(loc, gcache, heights[n], missing)) {
+                heights[n] = NAN;
+            }
+            n++;
+        }
+        next -= length;
+    }
+    if (n < max_heights) {
+        if (!available || !height_amsl_batch(points[num_points-1], gcache, heights[n], missing)) {
+            heights[n] = NAN;
+        }
+        n++;
+    }
+    return n;
+}
 
 /* 
    find difference between home terrain height and the terrain
@@ -270,6 +404,7 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
 
     float climb = 0;
     float lookahead_estimate = 0;
+    struct grid_cache *gcache = nullptr;
 
     // check for terrain at grid spacing intervals
     while (distance > 0) {
@@ -277,7 +412,7 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
         climb += climb_ratio * grid_spacing;
         distance -= grid_spacing;
         float height;
-        if (height_amsl(loc, height, false)) {
+        if (height_amsl_batch(loc, gcache, height, nullptr)) {
             float rise = (height - base_height) - climb;
             if (rise > lookahead_estimate) {
                 lookahead_estimate = rise;
@@ -320,6 +455,9 @@ void AP_Terrain::update(void)
     // check for pending rally data
     update_rally_data();
 
+    // load the blocks we are heading for
+    update_prefetch();
+
     // update capabilities and status
     if (allocate()) {
         if (!pos_valid) {
@@ -382,13 +520,20 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
+    uint16_t size = constrain_int16(config_cache_size, 4, TERRAIN_GRID_BLOCK_CACHE_MAX);
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    if (cache == nullptr && size > TERRAIN_GRID_BLOCK_CACHE_SIZE) {
+        // fall back to the default size
+        gcs().send_text(MAV_SEVERITY_WARNING, "Terrain: cache of %u too large", (unsigned)size);
+        size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+        cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    }
     if (cache == nullptr) {
         enable.set(0);
         gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    cache_size = size;
     return true;
 }
 
@@ -30,6 +30,18 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_Mission/AP_Mission.h>
 
+/*
+  on POSIX boards the IO thread keeps the degree files memory mapped,
+  and copies blocks that aren't in the cache from the mapping instead
+  of seeking and reading. Lookups still go through the grid cache
+ */
+#ifndef AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// number of degree files kept mapped
+#define TERRAIN_MMAP_FILES 4
+
 #define TERRAIN_DEBUG 0
 
 
@@ -51,8 +63,27 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache
+#ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 256
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
+#endif
+#endif
+
+// largest cache allowed by TERRAIN_CACHE_SZ
+#define TERRAIN_GRID_BLOCK_CACHE_MAX 4096
+
+// prefetching ahead of the vehicle needs a cache that can hold the
+// blocks in use as well as the ones being loaded
+#define TERRAIN_PREFETCH_MIN_CACHE 32
+
+// how far ahead of the vehicle to prefetch, in seconds of flight
+#define TERRAIN_PREFETCH_TIME_S 60
+
+// number of mission waypoints ahead of the vehicle to prefetch
+#define TERRAIN_PREFETCH_WAYPOINTS 3
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -119,6 +150,41 @@ public:
      */
     bool height_amsl(const Location &loc, float &height, bool corrected);
 
+    /*
+      grid blocks that were missing data for a batch of height
+      queries, given by the south west corner of each block
+     */
+    struct MissingBlocks {
+        static const uint8_t max_blocks = 8;
+        uint8_t count;
+        bool overflow; // more blocks were missing than would fit
+        Location corner[max_blocks];
+    };
+
+    /*
+      find the terrain heights in meters above sea level of count
+      locations in one pass. Adjacent locations in the same grid
+      block share one cache lookup, so ordering them along a path is
+      cheapest. heights[i] is NaN where data is not available, and if
+      missing is not null the blocks without data are added to it.
+
+      returns the number of heights found
+     */
+    uint16_t height_amsl(const Location *locs, uint16_t count, float *heights,
+                         MissingBlocks *missing = nullptr);
+
+    /*
+      sample terrain heights in meters above sea level along a
+      polyline, starting at the first point and every spacing meters
+      along the path after it, finishing with the last point. Heights
+      are as for the batch height_amsl().
+
+      returns the number of samples stored, at most max_heights
+     */
+    uint16_t height_amsl_path(const Location *points, uint16_t num_points, float spacing,
+                              float *heights, uint16_t max_heights,
+                              MissingBlocks *missing = nullptr);
+
     /* 
        find difference between home terrain height and the terrain
        height at the current location in meters. A positive result
@@ -278,6 +344,14 @@ private:
     // given a location, fill a grid_info structure
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
+    // interpolate the height at a grid_info from its grid block
+    bool interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height);
+
+    // uncorrected height for one location of a batch. gcache is the
+    // block used by the previous location, or nullptr
+    bool height_amsl_batch(const Location &loc, struct grid_cache *&gcache, float &height,
+                           MissingBlocks *missing);
+
     /*
       find a grid structure given a grid_info
     */
@@ -316,6 +390,8 @@ private:
      */
     int16_t find_io_idx(enum GridCacheState state);
     uint16_t get_block_crc(struct grid_block &block);
+    bool block_valid(struct grid_block &block, int32_t lat, int32_t lon);
+    uint32_t block_file_offset(const struct grid_block &block) const;
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
@@ -324,6 +400,25 @@ private:
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped degree files
+     */
+    struct mapped_file {
+        bool open;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        int fd;
+        uint8_t *data;
+        size_t length;
+        uint32_t last_use_ms;
+    } mapped_files[TERRAIN_MMAP_FILES];
+    struct mapped_file *mmap_file(int8_t lat_degrees, int16_t lon_degrees);
+    void mmap_close(struct mapped_file &mf);
+    bool mmap_read_block(void);
+    void mmap_empty_block(int32_t lat, int32_t lon);
+#endif
+
     /*
       check for missing mission terrain data
      */
@@ -334,19 +429,35 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      load grid blocks ahead of the vehicle into the cache
+     */
+    void update_prefetch(void);
+    bool prefetch_block(const Location &loc, uint16_t &budget);
+    bool prefetch_leg(const Location &from, const Location &to, uint16_t &budget);
+
 
     // parameters
     AP_Int8  enable;
     AP_Int16 grid_spacing; // meters between grid points
+    AP_Int16 config_cache_size;
 
     // reference to AP_Mission, so we can ask preload terrain data for 
     // all waypoints
     const AP_Mission &mission;
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // index of the block last returned by find_grid_cache(). Most
+    // lookups are for the same block as the one before, so this is
+    // checked before searching the whole cache
+    uint16_t last_cache_idx;
+
+    // number of blocks find_grid_cache() has had to load
+    uint32_t cache_loads;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -410,6 +521,18 @@ private:
     // grid spacing during rally check
     uint16_t last_rally_spacing;
 
+    // what the last prefetch walk started from. The walk is only
+    // repeated when one of these changes or it ran out of budget
+    struct {
+        int32_t grid_lat;
+        int32_t grid_lon;
+        int8_t heading_sector;  // -1 when not moving
+        uint16_t nav_index;
+        uint32_t mission_change_ms;
+        uint16_t spacing;
+        bool complete;
+    } prefetch;
+
     char *file_path = nullptr;
 
     // status
@@ -24,6 +24,7 @@
 #include <GCS_MAVLink/GCS.h>
 #include "AP_Terrain.h"
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 #if AP_TERRAIN_AVAILABLE
 
@@ -164,4 +165,127 @@ void AP_Terrain::update_rally_data(void)
     }
 }
 
+/*
+  start loading the grid block at a location if it isn't in the
+  cache. Returns false once budget blocks have been loaded or are
+  waiting for the disk
+ */
+bool AP_Terrain::prefetch_block(const Location &loc, uint16_t &budget)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    const uint32_t loads = cache_loads;
+    if (find_grid_cache(info).state == GRID_CACHE_DISKWAIT ||
+        cache_loads != loads) {
+        budget--;
+    }
+    return budget > 0;
+}
+
+/*
+  prefetch the blocks along a straight leg
+ */
+bool AP_Terrain::prefetch_leg(const Location &from, const Location &to, uint16_t &budget)
+{
+    // step at half the shortest block side so no block is missed
+    const float step = 0.5f * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+    const float distance = from.get_distance(to);
+    const float bearing = from.get_bearing_to(to) * 0.01f;
+    for (float d = step; d < distance; d += step) {
+        Location loc = from;
+        loc.offset_bearing(bearing, d);
+        if (!prefetch_block(loc, budget)) {
+            return false;
+        }
+    }
+    return prefetch_block(to, budget);
+}
+
+/*
+  load the grid blocks the vehicle is heading for before they are
+  needed, so terrain following doesn't have to wait for the disk. We
+  look along the velocity vector and then along the next few mission
+  legs. Only a quarter of the cache is used for new blocks on each
+  walk so the blocks in use are not pushed out. The walk is only
+  repeated when the vehicle moves to another block, turns, or the
+  mission moves on, or when the last walk ran out of budget
+ */
+void AP_Terrain::update_prefetch(void)
+{
+    if (cache_size < TERRAIN_PREFETCH_MIN_CACHE || grid_spacing <= 0) {
+        return;
+    }
+
+    AP_AHRS &ahrs = AP::ahrs();
+    Location loc;
+    if (!ahrs.get_position(loc)) {
+        return;
+    }
+
+    const Vector2f vel = ahrs.groundspeed_vector();
+    const float speed = vel.length();
+
+    // skip the walk if nothing it depends on has changed. Heading is
+    // compared in 45 degree sectors
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    int8_t heading_sector = -1;
+    if (speed > 1) {
+        heading_sector = wrap_360(degrees(atan2f(vel.y, vel.x)) + 22.5f) / 45;
+    }
+    const bool mission_running = mission.state() == AP_Mission::MISSION_RUNNING;
+    const uint16_t nav_index = mission_running ? mission.get_current_nav_index() : 0;
+    if (prefetch.complete &&
+        prefetch.grid_lat == info.grid_lat &&
+        prefetch.grid_lon == info.grid_lon &&
+        prefetch.heading_sector == heading_sector &&
+        prefetch.nav_index == nav_index &&
+        prefetch.mission_change_ms == mission.last_change_time_ms() &&
+        prefetch.spacing == grid_spacing) {
+        return;
+    }
+    prefetch.grid_lat = info.grid_lat;
+    prefetch.grid_lon = info.grid_lon;
+    prefetch.heading_sector = heading_sector;
+    prefetch.nav_index = nav_index;
+    prefetch.mission_change_ms = mission.last_change_time_ms();
+    prefetch.spacing = grid_spacing;
+    prefetch.complete = false;
+
+    uint16_t budget = cache_size / 4;
+
+    // along the velocity vector, at least one block ahead
+    if (speed > 1) {
+        const float block_size = MAX(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+        const float distance = MAX(speed * TERRAIN_PREFETCH_TIME_S, block_size);
+        Location ahead = loc;
+        ahead.offset(vel.x * distance / speed, vel.y * distance / speed);
+        if (!prefetch_leg(loc, ahead, budget)) {
+            return;
+        }
+    }
+
+    // along the mission legs from the current waypoint
+    uint16_t index = nav_index;
+    Location from = loc;
+    for (uint8_t n=0; n<TERRAIN_PREFETCH_WAYPOINTS && index != 0; index++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission.read_cmd_from_storage(index, cmd)) {
+            break;
+        }
+        if ((cmd.id != MAV_CMD_NAV_WAYPOINT &&
+             cmd.id != MAV_CMD_NAV_SPLINE_WAYPOINT) ||
+            (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+            continue;
+        }
+        if (!prefetch_leg(from, cmd.content.location, budget)) {
+            return;
+        }
+        from = cmd.content.location;
+        n++;
+    }
+
+    prefetch.complete = true;
+}
+
 #endif // AP_TERRAIN_AVAILABLE
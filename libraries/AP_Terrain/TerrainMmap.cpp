@@ -0,0 +1,191 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  read terrain grid blocks from memory mapped degree files
+
+  This only replaces the seek and read of a single block in the IO
+  thread on POSIX boards. Height lookups are still served from the
+  grid cache, and a missing block is still loaded one per io_timer
+  call; the mapping just avoids the file descriptor churn and lets
+  the kernel page cache do the readahead. The degree files are mapped
+  read only and stay mapped. Everything here runs on the IO thread,
+  as opening, mapping and the first touch of a page can all block.
+  Blocks filled in by the GCS are still written out through
+  AP::FS(), and a shared mapping sees those writes.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  unmap and close a degree file
+ */
+void AP_Terrain::mmap_close(struct mapped_file &mf)
+{
+    if (!mf.open) {
+        return;
+    }
+    if (mf.data != nullptr) {
+        munmap(mf.data, mf.length);
+    }
+    ::close(mf.fd);
+    mf.open = false;
+    mf.fd = -1;
+    mf.data = nullptr;
+    mf.length = 0;
+}
+
+/*
+  get the open degree file for a block, opening it in place of the
+  least recently used one if need be. The new file is opened before
+  anything is evicted, so a missing file doesn't cost a good mapping.
+  Returns nullptr with errno set if the file can't be opened
+ */
+AP_Terrain::mapped_file *AP_Terrain::mmap_file(int8_t lat_degrees, int16_t lon_degrees)
+{
+    struct mapped_file *mf = nullptr;
+    struct mapped_file *oldest = &mapped_files[0];
+    for (uint8_t i=0; i<TERRAIN_MMAP_FILES; i++) {
+        struct mapped_file &f = mapped_files[i];
+        if (f.open && f.lat_degrees == lat_degrees && f.lon_degrees == lon_degrees) {
+            mf = &f;
+            break;
+        }
+        if (!f.open || (oldest->open && f.last_use_ms < oldest->last_use_ms)) {
+            oldest = &f;
+        }
+    }
+
+    if (mf == nullptr) {
+        const char *terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        char path[128];
+        snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT",
+                 terrain_dir,
+                 lat_degrees<0?'S':'N',
+                 (unsigned)MIN(abs((int32_t)lat_degrees), 99),
+                 lon_degrees<0?'W':'E',
+                 (unsigned)MIN(abs((int32_t)lon_degrees), 999));
+        const int fd = ::open(path, O_RDONLY|O_CLOEXEC);
+        if (fd == -1) {
+            return nullptr;
+        }
+        mf = oldest;
+        mmap_close(*mf);
+        mf->fd = fd;
+        mf->open = true;
+        mf->lat_degrees = lat_degrees;
+        mf->lon_degrees = lon_degrees;
+    }
+
+    mf->last_use_ms = AP_HAL::millis();
+    return mf;
+}
+
+/*
+  read disk_block from the mapped degree file. Returns false if the
+  block has to be read through AP::FS() instead
+ */
+bool AP_Terrain::mmap_read_block(void)
+{
+    const struct grid_block &grid = disk_block.block;
+    const int32_t lat = grid.lat;
+    const int32_t lon = grid.lon;
+    struct mapped_file *mf = mmap_file(grid.lat_degrees, grid.lon_degrees);
+    if (mf == nullptr) {
+        if (errno != ENOENT) {
+            return false;
+        }
+        // no file yet, so no data for this block on disk
+        mmap_empty_block(lat, lon);
+        return true;
+    }
+
+    const uint32_t file_offset = block_file_offset(grid);
+    if (file_offset + sizeof(union grid_io_block) > mf->length) {
+        // more blocks may have been written since the file was
+        // mapped. Touching a mapping past the end of the file
+        // faults, so remap to the new length
+        struct stat st;
+        if (fstat(mf->fd, &st) != 0) {
+            return false;
+        }
+        if ((size_t)st.st_size > mf->length) {
+            if (mf->data != nullptr) {
+                munmap(mf->data, mf->length);
+                mf->data = nullptr;
+                mf->length = 0;
+            }
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, mf->fd, 0);
+            if (p == MAP_FAILED) {
+                return false;
+            }
+            mf->data = (uint8_t *)p;
+            mf->length = st.st_size;
+            // start reading the whole file into the page cache
+            madvise(mf->data, mf->length, MADV_WILLNEED);
+        }
+    }
+
+    if (file_offset + sizeof(union grid_io_block) > mf->length) {
+        // past the end of the file, so not written yet
+        mmap_empty_block(lat, lon);
+        return true;
+    }
+
+    memcpy(&disk_block, &mf->data[file_offset], sizeof(disk_block));
+    if (!block_valid(disk_block.block, lat, lon)) {
+        mmap_empty_block(lat, lon);
+        return true;
+    }
+
+#if TERRAIN_DEBUG
+    hal.console->printf("mapped block at %ld %ld mask=%07llx\n",
+                        (long)lat,
+                        (long)lon,
+                        (unsigned long long)disk_block.block.bitmap);
+#endif
+
+    disk_io_state = DiskIoDoneRead;
+    return true;
+}
+
+/*
+  complete a read of a block that isn't on disk
+ */
+void AP_Terrain::mmap_empty_block(int32_t lat, int32_t lon)
+{
+    memset(&disk_block, 0, sizeof(disk_block));
+    disk_block.block.lat = lat;
+    disk_block.block.lon = lon;
+    disk_io_state = DiskIoDoneRead;
+}
+
+#endif // AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
@@ -111,12 +111,22 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
 {
     uint16_t oldest_i = 0;
 
+    // try the block we found last time first
+    struct grid_cache &last = cache[last_cache_idx];
+    if (last.grid.lat == info.grid_lat &&
+        last.grid.lon == info.grid_lon &&
+        last.grid.spacing == grid_spacing) {
+        last.last_access_ms = AP_HAL::millis();
+        return last;
+    }
+
     // see if we have that grid
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].grid.lat == info.grid_lat && 
             cache[i].grid.lon == info.grid_lon &&
             cache[i].grid.spacing == grid_spacing) {
             cache[i].last_access_ms = AP_HAL::millis();
+            last_cache_idx = i;
             return cache[i];
         }
         if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
@@ -141,6 +151,8 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
+    last_cache_idx = oldest_i;
+    cache_loads++;
 
     return grid;
 }
@@ -168,6 +180,19 @@ int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
     return -1;
 }
 
+/*
+  check a block read from disk is the one we asked for and is intact
+ */
+bool AP_Terrain::block_valid(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return block.lat == lat &&
+        block.lon == lon &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
 /*
   get CRC for a block
  */
@@ -152,9 +152,20 @@ public:
         return GCS_MAVLINK::active_channel_mask() & (1 << (chan-MAVLINK_COMM_0));
     }
     bool is_streaming() const {
-        return sending_bucket_id != no_bucket_to_send;
+        return deferred_heap_count != 0;
     }
 
+    // statistics of the stream-rated message scheduler for this link
+    struct deferred_stats_t {
+        uint32_t sent;          // stream-rated messages sent
+        uint32_t no_space;      // sends stopped by a full link
+        uint32_t out_of_time;   // sends left for a loop with more time
+        uint32_t late;          // messages that fell more than an interval behind
+        uint16_t max_late_ms;   // most a message was sent late, since last logged
+        uint16_t max_cost_us;   // longest estimated send time, since last logged
+    };
+    const deferred_stats_t &get_deferred_stats() const { return deferred_stats; }
+
     mavlink_channel_t get_chan() const { return chan; }
     uint32_t get_last_heartbeat_time() const { return last_heartbeat_time; };
 
@@ -515,20 +526,35 @@ private:
     // cache of which deferred message should be sent next:
     int8_t next_deferred_message_to_send_cache = -1;
 
-    struct deferred_message_bucket_t {
-        Bitmask<MSG_LAST> ap_message_ids;
+    // stream-rated messages are kept in a binary min-heap on the time
+    // each one is next due, so finding the next message to send
+    // doesn't look at every scheduled message. Due times are 16 bit
+    // offsets from deferred_heap_base_ms to keep the entries small
+    struct deferred_message_entry_t {
+        uint16_t next_send_ms; // offset from deferred_heap_base_ms
         uint16_t interval_ms;
-        uint16_t last_sent_ms; // from AP_HAL::millis16()
+        uint8_t id;            // ap_message
+        uint8_t cost;          // estimated time to send, in 4us units
     };
-    deferred_message_bucket_t deferred_message_bucket[10];
-    static const uint8_t no_bucket_to_send = -1;
-    static const ap_message no_message_to_send = (ap_message)-1;
-    uint8_t sending_bucket_id = no_bucket_to_send;
-    Bitmask<MSG_LAST> bucket_message_ids_to_send;
-
-    ap_message next_deferred_bucket_message_to_send();
-    void find_next_bucket_to_send();
-    void remove_message_from_bucket(int8_t bucket, ap_message id);
+    static_assert(MSG_LAST < 256, "ap_message must fit in a uint8_t");
+    deferred_message_entry_t deferred_heap[MSG_LAST];
+    uint8_t deferred_heap_count = 0;
+    uint32_t deferred_heap_base_ms = 0;
+    // one more than the position of each ap_message in
+    // deferred_heap[], zero if it isn't scheduled
+    uint8_t deferred_heap_index[MSG_LAST] {};
+    deferred_stats_t deferred_stats {};
+
+    bool deferred_heap_before(uint8_t a, uint8_t b) const;
+    void deferred_heap_swap(uint8_t a, uint8_t b);
+    void deferred_heap_up(uint8_t i);
+    void deferred_heap_down(uint8_t i);
+    void deferred_heap_fix(uint8_t i);
+    void deferred_heap_remove(uint8_t i);
+    void deferred_heap_rebase(uint32_t now_ms);
+    // send the first stream-rated message if it is due. Returns
+    // false if nothing more can be sent this loop
+    bool send_next_deferred_heap_message();
 
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
@@ -564,10 +590,10 @@ private:
     // boolean that indicated that message intervals have been set
     // from streamrates:
     bool deferred_messages_initialised;
-    // return interval deferred message bucket should be sent after.
+    // return interval a stream-rated message should be sent after.
     // When sending parameters and waypoints this may be longer than
-    // the interval specified in "deferred"
-    uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const;
+    // its configured interval_ms
+    uint16_t get_reschedule_interval_ms(uint16_t interval_ms) const;
 
     bool do_try_send_message(const ap_message id);
 
@@ -677,9 +703,41 @@ private:
         int fd = -1;
         FTP_FILE_MODE mode; // work around AP_Filesystem not supporting file modes
         int16_t current_session;
+
+        // read cursor for the packed parameter file, see ftp_param_read()
+        struct {
+            uint16_t num_params;
+            uint32_t file_size;
+            uint32_t offset;        // file offset of the record for token
+            AP_Param::ParamToken token;
+            AP_Param *ap;
+            enum ap_var_type type;
+            char prev_name[AP_MAX_NAME_SIZE+1]; // name in the record before it
+        } param;
+
+        // text of the timing report, generated when it is opened
+        struct {
+            char *text;
+            uint32_t len;
+        } timing;
     };
     static struct ftp_state ftp;
 
+    // fd used while the packed parameter file is open
+    static const int ftp_param_fd = -2;
+
+    static bool ftp_param_open(void);
+    static void ftp_param_rewind(void);
+    static uint8_t ftp_param_pack(uint8_t *buf, char *name);
+    static ssize_t ftp_param_read(uint32_t offset, uint8_t *buf, uint32_t size);
+
+    // fd used while the HAL timing report is open
+    static const int ftp_timing_fd = -3;
+
+    static bool ftp_timing_open(void);
+    static void ftp_timing_close(void);
+    static ssize_t ftp_file_read(uint32_t offset, uint8_t *buf, uint32_t size);
+
     static void ftp_error(struct pending_ftp &response, FTP_ERROR error); // FTP helper method for packing a NAK
     static int gen_dir_entry(char *dest, size_t space, const char * path, const struct dirent * entry); // FTP helper for emitting a dir response
     static void ftp_list_dir(struct pending_ftp &request, struct pending_ftp &response);
@@ -764,7 +822,6 @@ private:
         uint16_t statustext_last_sent_ms;
         uint32_t behind;
         uint32_t out_of_time;
-        uint16_t fnbts_maxtime;
         uint32_t max_retry_deferred_body_us;
         uint8_t max_retry_deferred_body_type;
     } try_send_message_stats;
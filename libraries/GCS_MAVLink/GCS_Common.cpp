@@ -826,9 +826,9 @@ bool GCS_MAVLINK::should_send_message_in_delay_callback(const ap_message id) con
     return false;
 }
 
-uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
+uint16_t GCS_MAVLINK::get_reschedule_interval_ms(uint16_t interval) const
 {
-    uint32_t interval_ms = deferred.interval_ms;
+    uint32_t interval_ms = interval;
 
     interval_ms += stream_slowdown_ms;
 
@@ -850,77 +850,155 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
-// typical runtime on fmuv3: 5 microseconds for 3 buckets
-void GCS_MAVLINK::find_next_bucket_to_send()
+/*
+  deferred_heap[] helpers. The heap is ordered on next_send_ms, with
+  the message due soonest at the top
+ */
+bool GCS_MAVLINK::deferred_heap_before(uint8_t a, uint8_t b) const
 {
-#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
-    void *data = hal.scheduler->disable_interrupts_save();
-    uint32_t start_us = AP_HAL::micros();
-#endif
+    return deferred_heap[a].next_send_ms < deferred_heap[b].next_send_ms;
+}
 
-    const uint16_t now16_ms{AP_HAL::millis16()};
+void GCS_MAVLINK::deferred_heap_swap(uint8_t a, uint8_t b)
+{
+    const deferred_message_entry_t tmp = deferred_heap[a];
+    deferred_heap[a] = deferred_heap[b];
+    deferred_heap[b] = tmp;
+    deferred_heap_index[deferred_heap[a].id] = a + 1;
+    deferred_heap_index[deferred_heap[b].id] = b + 1;
+}
 
-    // all done sending this bucket... find another bucket...
-    sending_bucket_id = no_bucket_to_send;
-    uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
-            // no entries
-            continue;
+void GCS_MAVLINK::deferred_heap_up(uint8_t i)
+{
+    while (i > 0) {
+        const uint8_t parent = (i - 1) / 2;
+        if (!deferred_heap_before(i, parent)) {
+            break;
         }
-        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
-        const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
-        uint16_t ms_before_send_this_bucket;
-        if (ms_since_last_sent > interval) {
-            // should already have sent this bucket!
-            ms_before_send_this_bucket = 0;
-        } else {
-            ms_before_send_this_bucket = interval - ms_since_last_sent;
+        deferred_heap_swap(i, parent);
+        i = parent;
+    }
+}
+
+void GCS_MAVLINK::deferred_heap_down(uint8_t i)
+{
+    while (true) {
+        const uint8_t left = 2*i + 1;
+        if (left >= deferred_heap_count) {
+            break;
+        }
+        uint8_t child = left;
+        if (left + 1 < deferred_heap_count && deferred_heap_before(left + 1, left)) {
+            child = left + 1;
         }
-        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
-            sending_bucket_id = i;
-            ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+        if (!deferred_heap_before(child, i)) {
+            break;
         }
+        deferred_heap_swap(i, child);
+        i = child;
     }
-    if (sending_bucket_id != no_bucket_to_send) {
-        bucket_message_ids_to_send = deferred_message_bucket[sending_bucket_id].ap_message_ids;
+}
+
+// restore the heap order after entry i has changed
+void GCS_MAVLINK::deferred_heap_fix(uint8_t i)
+{
+    if (i > 0 && deferred_heap_before(i, (i - 1) / 2)) {
+        deferred_heap_up(i);
     } else {
-        bucket_message_ids_to_send.clearall();
+        deferred_heap_down(i);
     }
+}
 
-#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
-    uint32_t delta_us = AP_HAL::micros() - start_us;
-    hal.scheduler->restore_interrupts(data);
-    if (delta_us > try_send_message_stats.fnbts_maxtime) {
-        try_send_message_stats.fnbts_maxtime = delta_us;
+void GCS_MAVLINK::deferred_heap_remove(uint8_t i)
+{
+    deferred_heap_index[deferred_heap[i].id] = 0;
+    deferred_heap_count--;
+    if (i == deferred_heap_count) {
+        return;
     }
-#endif
+    deferred_heap[i] = deferred_heap[deferred_heap_count];
+    deferred_heap_index[deferred_heap[i].id] = i + 1;
+    deferred_heap_fix(i);
+}
+
+/*
+  move deferred_heap_base_ms forward before it falls too far behind
+  now for a due time up to 60 seconds ahead to fit in 16 bits.
+  Messages more than 2 seconds late are treated as 2 seconds late,
+  which doesn't change their order in the heap
+ */
+void GCS_MAVLINK::deferred_heap_rebase(uint32_t now_ms)
+{
+    if (now_ms - deferred_heap_base_ms < 4096) {
+        return;
+    }
+    const uint32_t shift = now_ms - deferred_heap_base_ms - 2048;
+    for (uint8_t i=0; i<deferred_heap_count; i++) {
+        uint16_t &next_send_ms = deferred_heap[i].next_send_ms;
+        next_send_ms = next_send_ms > shift ? next_send_ms - shift : 0;
+    }
+    deferred_heap_base_ms += shift;
 }
 
-ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send()
+/*
+  send the stream-rated message at the top of the heap if it is due,
+  and reschedule it. Messages are held back if the estimate of how
+  long they take to send is more than the time left in this loop,
+  unless they are already an interval late
+ */
+bool GCS_MAVLINK::send_next_deferred_heap_message()
 {
-    if (sending_bucket_id == no_bucket_to_send) {
-        // could happen if all streamrates are zero?
-        return no_message_to_send;
+    if (deferred_heap_count == 0) {
+        return false;
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    deferred_heap_rebase(now_ms);
+    const deferred_message_entry_t &top = deferred_heap[0];
+    const int32_t late_ms = int32_t(now_ms - (deferred_heap_base_ms + top.next_send_ms));
+    if (late_ms < 0) {
+        // nothing due yet
+        return false;
+    }
+    const ap_message id = (ap_message)top.id;
+    if (late_ms < top.interval_ms &&
+        !hal.scheduler->in_delay_callback() &&
+        top.cost * 4U > AP::scheduler().time_available_usec()) {
+        deferred_stats.out_of_time++;
+        return false;
     }
 
-    const uint16_t now16_ms = AP_HAL::millis16();
-    const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[sending_bucket_id].last_sent_ms;
-    if (ms_since_last_sent < get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id])) {
-        // not time to send this bucket
-        return no_message_to_send;
+    const uint32_t start_us = AP_HAL::micros();
+    if (!do_try_send_message(id)) {
+        deferred_stats.no_space++;
+        return false;
     }
+    const uint32_t cost_us = AP_HAL::micros() - start_us;
 
-    const int16_t next = bucket_message_ids_to_send.first_set();
-    if (next == -1) {
-        // should not happen
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        AP_HAL::panic("next_deferred_bucket_message_to_send called on empty bucket");
-#endif
-        find_next_bucket_to_send();
-        return no_message_to_send;
+    // sending may have changed the schedule, so look the message up again
+    const uint8_t pos = deferred_heap_index[id];
+    if (pos == 0) {
+        return true;
     }
-    return (ap_message)next;
+    deferred_message_entry_t &entry = deferred_heap[pos-1];
+
+    // moving average of the send time
+    entry.cost = (3U * entry.cost + MIN(cost_us / 4U, 255U) + 3U) / 4U;
+
+    deferred_stats.sent++;
+    deferred_stats.max_late_ms = MAX(deferred_stats.max_late_ms, (uint16_t)MIN(late_ms, (int32_t)UINT16_MAX));
+    deferred_stats.max_cost_us = MAX(deferred_stats.max_cost_us, (uint16_t)(entry.cost * 4U));
+
+    const uint16_t interval_ms = get_reschedule_interval_ms(entry.interval_ms);
+    if (late_ms - interval_ms >= interval_ms) {
+        // more than an interval behind. Don't try to catch up with a
+        // burst, just carry on from now
+        deferred_stats.late++;
+        entry.next_send_ms = now_ms + interval_ms - deferred_heap_base_ms;
+    } else {
+        entry.next_send_ms += interval_ms;
+    }
+    deferred_heap_fix(pos-1);
+    return true;
 }
 
 // call try_send_message if appropriate.  Incorporates debug code to
@@ -1083,25 +1161,14 @@ void GCS_MAVLINK::update_send()
             continue;
         }
 
-        ap_message next = next_deferred_bucket_message_to_send();
-        if (next != no_message_to_send) {
-            if (!do_try_send_message(next)) {
-                break;
-            }
-            bucket_message_ids_to_send.clear(next);
-            if (bucket_message_ids_to_send.count() == 0) {
-                // we sent everything in the bucket.  Reschedule it.
-                deferred_message_bucket[sending_bucket_id].last_sent_ms +=
-                    get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id]);
-                find_next_bucket_to_send();
-            }
+        if (send_next_deferred_heap_message()) {
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
-                const uint32_t stop = AP_HAL::micros();
-                const uint32_t delta = stop - retry_deferred_body_start;
-                if (delta > try_send_message_stats.max_retry_deferred_body_us) {
-                    try_send_message_stats.max_retry_deferred_body_us = delta;
-                    try_send_message_stats.max_retry_deferred_body_type = 3;
-                }
+            const uint32_t stop = AP_HAL::micros();
+            const uint32_t delta = stop - retry_deferred_body_start;
+            if (delta > try_send_message_stats.max_retry_deferred_body_us) {
+                try_send_message_stats.max_retry_deferred_body_us = delta;
+                try_send_message_stats.max_retry_deferred_body_type = 3;
+            }
 #endif
             continue;
         }
@@ -1126,24 +1193,6 @@ void GCS_MAVLINK::update_send()
     }
 }
 
-void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
-{
-    deferred_message_bucket[bucket].ap_message_ids.clear(id);
-
-    if (bucket == sending_bucket_id) {
-        bucket_message_ids_to_send.clear(id);
-    }
-
-    if (deferred_message_bucket[bucket].ap_message_ids.count() == 0) {
-        // bucket empty.  Free it:
-        deferred_message_bucket[bucket].interval_ms = 0;
-        deferred_message_bucket[bucket].last_sent_ms = 0;
-        if (sending_bucket_id == bucket) {
-            find_next_bucket_to_send();
-        }
-    }
-}
-
 bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_ms)
 {
     if (id == MSG_NEXT_PARAM) {
@@ -1162,6 +1211,12 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         interval_ms = AP::scheduler().get_loop_period_us()/800.0f;
     }
 
+    // stream-rated messages are due at most a minute ahead, as for
+    // rescheduling in get_reschedule_interval_ms()
+    if (interval_ms > 60000) {
+        interval_ms = 60000;
+    }
+
     // check if it's a specially-handled message:
     const int8_t deferred_offset = get_deferred_message_index(id);
     if (deferred_offset != -1) {
@@ -1170,83 +1225,38 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         return true;
     }
 
-    // see which bucket has the closest interval:
-    int8_t closest_bucket = -1;
-    uint16_t closest_bucket_interval_delta = UINT16_MAX;
-    int8_t in_bucket = -1;
-    int8_t empty_bucket_id = -1;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
-        if (bucket.interval_ms == 0) {
-            // unused bucket
-            if (empty_bucket_id == -1) {
-                empty_bucket_id = i;
-            }
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-            if (bucket.ap_message_ids.count() != 0) {
-                AP_HAL::panic("Bucket %u has zero interval but with ids set", i);
-            }
-#endif
-            continue;
-        }
-        if (bucket.ap_message_ids.get(id)) {
-            in_bucket = i;
-        }
-        const uint16_t interval_delta = abs(bucket.interval_ms - interval_ms);
-        if (interval_delta < closest_bucket_interval_delta) {
-            closest_bucket = i;
-            closest_bucket_interval_delta = interval_delta;
-        }
+    if (id >= MSG_LAST) {
+        return false;
     }
-
-    if (in_bucket == -1 && interval_ms == 0) {
-        // not in a bucket and told to remove from scheduling
+    const uint8_t pos = deferred_heap_index[id];
+    if (interval_ms == 0) {
+        // told to remove from scheduling
+        if (pos != 0) {
+            deferred_heap_remove(pos-1);
+        }
         return true;
     }
 
-    if (in_bucket != -1) {
-        if (interval_ms == 0) {
-            // remove it
-            remove_message_from_bucket(in_bucket, id);
-            return true;
-        }
-        if (closest_bucket_interval_delta == 0 &&
-            in_bucket == closest_bucket) {
-            // don't need to move it
-            return true;
+    const uint32_t now_ms = AP_HAL::millis();
+    deferred_heap_rebase(now_ms);
+    if (pos != 0) {
+        deferred_message_entry_t &entry = deferred_heap[pos-1];
+        if (entry.interval_ms != interval_ms) {
+            entry.interval_ms = interval_ms;
+            entry.next_send_ms = now_ms + interval_ms - deferred_heap_base_ms;
+            deferred_heap_fix(pos-1);
         }
-        // remove from existing bucket
-        remove_message_from_bucket(in_bucket, id);
-        if (empty_bucket_id == -1 &&
-            deferred_message_bucket[in_bucket].ap_message_ids.count() == 0) {
-            empty_bucket_id = in_bucket;
-        }
-    }
-
-    if (closest_bucket == -1 && empty_bucket_id == -1) {
-        // gah?!
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        ::fprintf(stderr, "no buckets?!\n");
-        abort();
-#endif
-        return false;
-    }
-
-    if (closest_bucket_interval_delta != 0 &&
-        empty_bucket_id != -1) {
-        // allocate a bucket for this interval
-        deferred_message_bucket[empty_bucket_id].interval_ms = interval_ms;
-        deferred_message_bucket[empty_bucket_id].last_sent_ms = AP_HAL::millis16();
-        closest_bucket = empty_bucket_id;
-        closest_bucket_interval_delta = 0;
+        return true;
     }
 
-    deferred_message_bucket[closest_bucket].ap_message_ids.set(id);
-
-    if (sending_bucket_id == no_bucket_to_send) {
-        sending_bucket_id = closest_bucket;
-        bucket_message_ids_to_send = deferred_message_bucket[closest_bucket].ap_message_ids;
-    }
+    const uint8_t i = deferred_heap_count++;
+    deferred_message_entry_t &entry = deferred_heap[i];
+    entry.next_send_ms = now_ms + interval_ms - deferred_heap_base_ms;
+    entry.interval_ms = interval_ms;
+    entry.id = id;
+    entry.cost = 0;
+    deferred_heap_index[id] = i + 1;
+    deferred_heap_up(i);
 
     return true;
 }
@@ -1429,13 +1439,6 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
                             try_send_message_stats.behind);
             try_send_message_stats.behind = 0;
         }
-        if (try_send_message_stats.fnbts_maxtime) {
-            gcs().send_text(MAV_SEVERITY_INFO,
-                            "GCS.chan(%u): fnbts_maxtime=%uus",
-                            chan,
-                            try_send_message_stats.fnbts_maxtime);
-            try_send_message_stats.fnbts_maxtime = 0;
-        }
         if (try_send_message_stats.max_retry_deferred_body_us) {
             gcs().send_text(MAV_SEVERITY_INFO,
                             "GCS.chan(%u): retry_body_maxtime=%uus (%u)",
@@ -1446,17 +1449,6 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
             try_send_message_stats.max_retry_deferred_body_us = 0;
         }
 
-        for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-            gcs().send_text(MAV_SEVERITY_INFO,
-                            "B. intvl. (%u): %u %u %u %u %u",
-                            chan,
-                            deferred_message_bucket[0].interval_ms,
-                            deferred_message_bucket[1].interval_ms,
-                            deferred_message_bucket[2].interval_ms,
-                            deferred_message_bucket[3].interval_ms,
-                            deferred_message_bucket[4].interval_ms);
-        }
-
         try_send_message_stats.statustext_last_sent_ms = now16_ms;
     }
 #endif
@@ -1484,6 +1476,21 @@ void GCS_MAVLINK::log_mavlink_stats()
     };
 
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    // scheduler statistics for this link
+    AP::logger().Write("MAVS", "TimeUS,chan,nsch,sent,nosp,oot,late,mlate,mcost",
+                       "s#-------", "F--------", "QBBIIIIHH",
+                       AP_HAL::micros64(),
+                       (uint8_t)chan,
+                       deferred_heap_count,
+                       deferred_stats.sent,
+                       deferred_stats.no_space,
+                       deferred_stats.out_of_time,
+                       deferred_stats.late,
+                       deferred_stats.max_late_ms,
+                       deferred_stats.max_cost_us);
+    deferred_stats.max_late_ms = 0;
+    deferred_stats.max_cost_us = 0;
 }
 
 /*
@@ -2312,13 +2319,10 @@ bool GCS_MAVLINK::get_ap_message_interval(ap_message id, uint16_t &interval_ms)
         return true;
     }
 
-    // check the deferred message buckets:
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
-        if (bucket.ap_message_ids.get(id)) {
-            interval_ms = bucket.interval_ms;
-            return true;
-        }
+    // check the stream-rated messages:
+    if (id < MSG_LAST && deferred_heap_index[id] != 0) {
+        interval_ms = deferred_heap[deferred_heap_index[id]-1].interval_ms;
+        return true;
     }
 
     return false;
@@ -203,10 +203,11 @@ void GCS_MAVLINK::ftp_worker(void) {
                 case FTP_OP::TerminateSession:
                 case FTP_OP::ResetSessions:
                     // we already handled this, just listed for completeness
-                    if (ftp.fd != -1) {
+                    if (ftp.fd >= 0) {
                         AP::FS().close(ftp.fd);
-                        ftp.fd = -1;
                     }
+                    ftp_timing_close();
+                    ftp.fd = -1;
                     ftp.current_session = -1;
                     reply.opcode = FTP_OP::Ack;
                     break;
@@ -230,6 +231,36 @@ void GCS_MAVLINK::ftp_worker(void) {
 
                         request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
+                        if (strcmp((char *)request.data, "@PARAM/param.pck") == 0) {
+                            if (!ftp_param_open()) {
+                                ftp_error(reply, FTP_ERROR::Fail);
+                                break;
+                            }
+                            ftp.fd = ftp_param_fd;
+                            ftp.mode = FTP_FILE_MODE::Read;
+                            ftp.current_session = request.session;
+
+                            reply.opcode = FTP_OP::Ack;
+                            reply.size = sizeof(uint32_t);
+                            *((int32_t *)reply.data) = (int32_t)ftp.param.file_size;
+                            break;
+                        }
+
+                        if (strcmp((char *)request.data, "@SYS/timing.txt") == 0) {
+                            if (!ftp_timing_open()) {
+                                ftp_error(reply, FTP_ERROR::Fail);
+                                break;
+                            }
+                            ftp.fd = ftp_timing_fd;
+                            ftp.mode = FTP_FILE_MODE::Read;
+                            ftp.current_session = request.session;
+
+                            reply.opcode = FTP_OP::Ack;
+                            reply.size = sizeof(uint32_t);
+                            *((int32_t *)reply.data) = (int32_t)ftp.timing.len;
+                            break;
+                        }
+
                         // get the file size
                         struct stat st;
                         if (AP::FS().stat((char *)request.data, &st)) {
@@ -266,14 +297,8 @@ void GCS_MAVLINK::ftp_worker(void) {
                             break;
                         }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-
                         // fill the buffer
-                        const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, request.size);
+                        const ssize_t read_bytes = ftp_file_read(request.offset, reply.data, request.size);
                         if (read_bytes == -1) {
                             ftp_error(reply, FTP_ERROR::FailErrno);
                             break;
@@ -448,17 +473,12 @@ void GCS_MAVLINK::ftp_worker(void) {
                             break;
                         }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-
                         bool more_pending = true;
                         const uint32_t transfer_size = 100;
                         for (uint32_t i = 0; (i < transfer_size) && more_pending; i++) {
                             // fill the buffer
-                            const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, sizeof(reply.data));
+                            const ssize_t read_bytes = ftp_file_read(request.offset + i * sizeof(reply.data),
+                                                                     reply.data, sizeof(reply.data));
                             if (read_bytes == -1) {
                                 ftp_error(reply, FTP_ERROR::FailErrno);
                                 more_pending = false;
@@ -609,4 +629,229 @@ void GCS_MAVLINK::ftp_list_dir(struct pending_ftp &request, struct pending_ftp &
     AP::FS().closedir(dir);
 }
 
+/*
+  read from the open file at offset, returning -1 with errno set on error
+ */
+ssize_t GCS_MAVLINK::ftp_file_read(uint32_t offset, uint8_t *buf, uint32_t size)
+{
+    if (ftp.fd == ftp_param_fd) {
+        return ftp_param_read(offset, buf, size);
+    }
+    if (ftp.fd == ftp_timing_fd) {
+        if (offset >= ftp.timing.len) {
+            return 0;
+        }
+        const uint32_t n = MIN(size, ftp.timing.len - offset);
+        memcpy(buf, &ftp.timing.text[offset], n);
+        return n;
+    }
+    if (AP::FS().lseek(ftp.fd, offset, SEEK_SET) == -1) {
+        return -1;
+    }
+    return AP::FS().read(ftp.fd, buf, size);
+}
+
+/*
+  the virtual file @PARAM/param.pck holds all parameters in one packed
+  stream, so a GCS can fetch them with a burst read instead of one
+  PARAM_VALUE message each. The file is generated as it is read and
+  never held in memory. It is a header of
+
+    uint16_t magic (0x671C)
+    uint16_t number of parameters
+
+  followed by one record per parameter, in PARAM_VALUE index order
+
+    uint8_t  type, ap_var_type from AP_PARAM_INT8 (1) to AP_PARAM_FLOAT (4)
+    uint8_t  common_len<<4 | (suffix_len-1)
+    char     suffix[suffix_len], the name after the common_len
+             characters it shares with the previous name
+    value    1, 2 or 4 bytes depending on type
+    default  same size as value
+
+  Record lengths only depend on the names, so the layout does not move
+  if values change while the file is being read.
+ */
+static const uint16_t param_file_magic = 0x671C;
+static const uint8_t param_file_header_size = 4;
+
+void GCS_MAVLINK::ftp_param_rewind(void)
+{
+    ftp.param.offset = param_file_header_size;
+    ftp.param.prev_name[0] = 0;
+    ftp.param.ap = AP_Param::first(&ftp.param.token, &ftp.param.type);
+    if (ftp.param.ap != nullptr && ftp.param.type > AP_PARAM_FLOAT) {
+        ftp.param.ap = AP_Param::next_scalar(&ftp.param.token, &ftp.param.type);
+    }
+}
+
+/*
+  pack the record for the parameter at the cursor into buf, which
+  must have room for the largest record. Returns the record length
+ */
+uint8_t GCS_MAVLINK::ftp_param_pack(uint8_t *buf, char *name)
+{
+    const AP_Param *ap = ftp.param.ap;
+    ap->copy_name_token(ftp.param.token, name, AP_MAX_NAME_SIZE+1, true);
+    const uint8_t name_len = MAX(strnlen(name, AP_MAX_NAME_SIZE), 1U);
+    uint8_t common = 0;
+    while (common < name_len-1 && common < 15 && name[common] == ftp.param.prev_name[common]) {
+        common++;
+    }
+
+    uint8_t len = 0;
+    buf[len++] = ftp.param.type;
+    buf[len++] = (common << 4) | (name_len - common - 1);
+    memcpy(&buf[len], &name[common], name_len - common);
+    len += name_len - common;
+
+    float def = 0;
+    ap->get_token_default(ftp.param.token, def);
+    switch (ftp.param.type) {
+    case AP_PARAM_INT8: {
+        const int8_t v[2] = { ((const AP_Int8 *)ap)->get(), (int8_t)def };
+        memcpy(&buf[len], v, sizeof(v));
+        len += sizeof(v);
+        break;
+    }
+    case AP_PARAM_INT16: {
+        const int16_t v[2] = { ((const AP_Int16 *)ap)->get(), (int16_t)def };
+        memcpy(&buf[len], v, sizeof(v));
+        len += sizeof(v);
+        break;
+    }
+    case AP_PARAM_INT32: {
+        const int32_t v[2] = { ((const AP_Int32 *)ap)->get(), (int32_t)def };
+        memcpy(&buf[len], v, sizeof(v));
+        len += sizeof(v);
+        break;
+    }
+    default: {
+        const float v[2] = { ((const AP_Float *)ap)->get(), def };
+        memcpy(&buf[len], v, sizeof(v));
+        len += sizeof(v);
+        break;
+    }
+    }
+    return len;
+}
+
+/*
+  size up the parameter file and reset the read cursor
+ */
+bool GCS_MAVLINK::ftp_param_open(void)
+{
+    uint8_t buf[2+AP_MAX_NAME_SIZE+8];
+    char name[AP_MAX_NAME_SIZE+1];
+
+    ftp.param.num_params = 0;
+    ftp.param.file_size = param_file_header_size;
+    for (ftp_param_rewind(); ftp.param.ap != nullptr;
+         ftp.param.ap = AP_Param::next_scalar(&ftp.param.token, &ftp.param.type)) {
+        ftp.param.file_size += ftp_param_pack(buf, name);
+        strncpy(ftp.param.prev_name, name, sizeof(ftp.param.prev_name));
+        ftp.param.num_params++;
+    }
+    ftp_param_rewind();
+    return ftp.param.num_params > 0;
+}
+
+/*
+  read from the parameter file. Reads normally follow each other, so
+  the cursor is kept on the record the last read ended in and only
+  goes back to the start for an earlier offset
+ */
+ssize_t GCS_MAVLINK::ftp_param_read(uint32_t offset, uint8_t *buf, uint32_t size)
+{
+    if (offset < ftp.param.offset) {
+        ftp_param_rewind();
+    }
+
+    uint32_t n = 0;
+    if (offset < param_file_header_size) {
+        const uint16_t header[2] { param_file_magic, ftp.param.num_params };
+        n = MIN(size, param_file_header_size - offset);
+        memcpy(buf, ((const uint8_t *)header) + offset, n);
+    }
+
+    uint8_t record[2+AP_MAX_NAME_SIZE+8];
+    char name[AP_MAX_NAME_SIZE+1];
+    while (n < size && ftp.param.ap != nullptr) {
+        const uint8_t len = ftp_param_pack(record, name);
+        if (offset + n < ftp.param.offset + len) {
+            const uint32_t from = offset + n - ftp.param.offset;
+            const uint32_t count = MIN(len - from, size - n);
+            memcpy(&buf[n], &record[from], count);
+            n += count;
+            if (from + count < len) {
+                // the next read continues within this record
+                break;
+            }
+        }
+        strncpy(ftp.param.prev_name, name, sizeof(ftp.param.prev_name));
+        ftp.param.offset += len;
+        ftp.param.ap = AP_Param::next_scalar(&ftp.param.token, &ftp.param.type);
+    }
+    return n;
+}
+
+/*
+  the virtual file @SYS/timing.txt is a text report of the execution
+  time statistics kept by the HAL, one line per thread or callback, as
+  returned by AP_HAL::Util::get_timing_stats(). Times are in
+  microseconds and cover everything since boot. The report is made
+  when the file is opened so it is consistent across reads
+ */
+bool GCS_MAVLINK::ftp_timing_open(void)
+{
+    static const char header[] = "name                 count      min     mean      max      p99   overruns\n";
+    const uint8_t line_len = sizeof(header) - 1;
+
+    AP_HAL::Util::TimingStats stats;
+    uint8_t count = 0;
+    while (count < UINT8_MAX && hal.util->get_timing_stats(count, stats)) {
+        count++;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    // entries may be added while we fill the buffer, so only report
+    // the ones we counted
+    const uint32_t size = (count + 1) * line_len + 1;
+    ftp_timing_close();
+    ftp.timing.text = (char *)malloc(size);
+    if (ftp.timing.text == nullptr) {
+        return false;
+    }
+
+    memcpy(ftp.timing.text, header, line_len);
+    uint32_t len = line_len;
+    for (uint8_t i = 0; i < count && hal.util->get_timing_stats(i, stats); i++) {
+        const int n = hal.util->snprintf(&ftp.timing.text[len], size - len,
+                                         "%-15.15s %10lu %8lu %8lu %8lu %8lu %10lu\n",
+                                         stats.name,
+                                         (unsigned long)stats.count,
+                                         (unsigned long)MIN(stats.min_us, 99999999U),
+                                         (unsigned long)MIN(stats.mean_us, 99999999U),
+                                         (unsigned long)MIN(stats.max_us, 99999999U),
+                                         (unsigned long)MIN(stats.p99_us, 99999999U),
+                                         (unsigned long)stats.overruns);
+        if (n <= 0 || uint32_t(n) >= size - len) {
+            break;
+        }
+        len += n;
+    }
+    ftp.timing.len = len;
+
+    return true;
+}
+
+void GCS_MAVLINK::ftp_timing_close(void)
+{
+    free(ftp.timing.text);
+    ftp.timing.text = nullptr;
+    ftp.timing.len = 0;
+}
+
 #endif // HAVE_FILESYSTEM_SUPPORT
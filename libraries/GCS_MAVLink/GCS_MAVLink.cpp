@@ -42,6 +42,15 @@ bool gcs_alternative_active[MAVLINK_COMM_NUM_BUFFERS];
 // per-channel lock
 static HAL_Semaphore chan_locks[MAVLINK_COMM_NUM_BUFFERS];
 
+// space reserved in the UART transmit buffer for the packet being
+// sent on each channel, taken with the channel lock
+static struct {
+    ByteBuffer::IoVec vec[2];
+    uint8_t n_vec;
+    uint8_t idx;
+    uint16_t written;
+} chan_tx[MAVLINK_COMM_NUM_BUFFERS];
+
 mavlink_system_t mavlink_system = {7,1};
 
 // mask of serial ports disabled to allow for SERIAL_CONTROL
@@ -127,6 +136,24 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
         // an alternative protocol is active
         return;
     }
+    auto &tx = chan_tx[chan];
+    if (tx.n_vec != 0) {
+        // copy into the space reserved for the packet
+        while (len > 0 && tx.idx < tx.n_vec) {
+            ByteBuffer::IoVec &v = tx.vec[tx.idx];
+            const uint32_t n = MIN(v.len, (uint32_t)len);
+            memcpy(v.data, buf, n);
+            v.data += n;
+            v.len -= n;
+            buf += n;
+            len -= n;
+            tx.written += n;
+            if (v.len == 0) {
+                tx.idx++;
+            }
+        }
+        return;
+    }
     const size_t written = mavlink_comm_port[chan]->write(buf, len);
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     if (written < len) {
@@ -140,9 +167,19 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
 /*
   lock a channel for send
  */
-void comm_send_lock(mavlink_channel_t chan)
+void comm_send_lock(mavlink_channel_t chan, uint16_t size)
 {
     chan_locks[(uint8_t)chan].take_blocking();
+    if (!valid_channel(chan) || gcs_alternative_active[chan]) {
+        return;
+    }
+    // reserve the whole packet in the UART transmit buffer so the
+    // pieces are written into it directly with one UART lock. If the
+    // UART can't do that comm_send_buffer() falls back to write()
+    auto &tx = chan_tx[chan];
+    tx.idx = 0;
+    tx.written = 0;
+    tx.n_vec = mavlink_comm_port[chan]->tx_reserve(tx.vec, size);
 }
 
 /*
@@ -150,5 +187,12 @@ void comm_send_lock(mavlink_channel_t chan)
  */
 void comm_send_unlock(mavlink_channel_t chan)
 {
+    if (valid_channel(chan)) {
+        auto &tx = chan_tx[chan];
+        if (tx.n_vec != 0) {
+            mavlink_comm_port[chan]->tx_commit(tx.written);
+            tx.n_vec = 0;
+        }
+    }
     chan_locks[(uint8_t)chan].give();
 }
@@ -27,7 +27,119 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) :
+    num_routes(0),
+    all_channel_mask(0),
+    last_expiry_check_ms(0),
+    no_route_mask(0)
+{
+    memset(routes, 0, sizeof(routes));
+    memset(system_channel_mask, 0, sizeof(system_channel_mask));
+}
+
+/*
+  hash a sysid/compid into the route table
+ */
+uint16_t MAVLink_routing::route_hash(uint8_t sysid, uint8_t compid)
+{
+    // components of one system tend to have nearby compids, so spread
+    // the sysid across the table and step by compid
+    return (uint16_t(sysid) * 97U + compid) & (MAVLINK_ROUTE_TABLE_SIZE - 1);
+}
+
+/*
+  find the table index of a route, or -1
+ */
+int16_t MAVLink_routing::find_route_index(uint8_t sysid, uint8_t compid) const
+{
+    uint16_t i = route_hash(sysid, compid);
+    while (routes[i].sysid != 0) {
+        if (routes[i].sysid == sysid && routes[i].compid == compid) {
+            return i;
+        }
+        i = (i + 1) & (MAVLINK_ROUTE_TABLE_SIZE - 1);
+    }
+    return -1;
+}
+
+const MAVLink_routing::route *MAVLink_routing::find_route(uint8_t sysid, uint8_t compid) const
+{
+    const int16_t i = find_route_index(sysid, compid);
+    return i == -1 ? nullptr : &routes[i];
+}
+
+/*
+  remove the route at index i, moving later entries of its probe
+  sequence back so lookups don't need tombstones. The caller must
+  call update_channel_masks() afterwards
+ */
+void MAVLink_routing::remove_route(uint16_t i)
+{
+    const uint16_t mask = MAVLINK_ROUTE_TABLE_SIZE - 1;
+    uint16_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (routes[j].sysid == 0) {
+            break;
+        }
+        // entry j can fill the hole at i if its home slot is not
+        // cyclically within (i, j]
+        const uint16_t home = route_hash(routes[j].sysid, routes[j].compid);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            routes[i] = routes[j];
+            i = j;
+        }
+    }
+    memset(&routes[i], 0, sizeof(routes[i]));
+    num_routes--;
+}
+
+/*
+  rebuild the per-system and overall channel masks
+ */
+void MAVLink_routing::update_channel_masks(void)
+{
+    memset(system_channel_mask, 0, sizeof(system_channel_mask));
+    all_channel_mask = 0;
+    for (uint16_t i=0; i<MAVLINK_ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid != 0) {
+            system_channel_mask[routes[i].sysid] |= routes[i].channel_mask;
+            all_channel_mask |= routes[i].channel_mask;
+        }
+    }
+}
+
+/*
+  forget routes that have not been heard from recently. A component
+  that comes back is learned again from its next packet
+ */
+void MAVLink_routing::expire_routes(void)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_expiry_check_ms < 1000) {
+        return;
+    }
+    last_expiry_check_ms = now_ms;
+
+    bool removed = false;
+    for (uint16_t i=0; i<MAVLINK_ROUTE_TABLE_SIZE; i++) {
+        // removal can move a later entry into slot i, so look at
+        // the same slot again
+        while (routes[i].sysid != 0 &&
+               now_ms - routes[i].last_seen_ms > MAVLINK_ROUTE_EXPIRY_MS) {
+#if ROUTING_DEBUG
+            ::printf("expired route %u %u\n",
+                     (unsigned)routes[i].sysid,
+                     (unsigned)routes[i].compid);
+#endif
+            remove_route(i);
+            removed = true;
+        }
+    }
+    if (removed) {
+        update_channel_masks();
+    }
+}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -134,42 +246,55 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
         return true;
     }
 
-    // forward on any channels matching the targets
+    // work out the channels to forward on
+    uint8_t fwd_mask;
+    uint8_t private_ok_mask = 0;
+    int16_t target_route = -1;
+    if (target_system > 0 && target_component >= 0) {
+        target_route = find_route_index(target_system, target_component);
+        if (target_route != -1) {
+            // private channels only get messages targeted exactly at
+            // a route on them
+            private_ok_mask = routes[target_route].channel_mask;
+        }
+    }
+    if (broadcast_system) {
+        fwd_mask = all_channel_mask;
+    } else if (broadcast_component || !match_system) {
+        fwd_mask = system_channel_mask[target_system];
+    } else {
+        fwd_mask = private_ok_mask;
+    }
+    fwd_mask &= ~(1U<<(in_channel-MAVLINK_COMM_0));
+
     bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-    
-        // Skip if channel is private and the target system or component IDs do not match
-        if ((GCS_MAVLINK::is_private(routes[i].channel)) &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(fwd_mask & (1U<<i))) {
             continue;
         }
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
 
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
+        // Skip if channel is private and the target system or component IDs do not match
+        if (GCS_MAVLINK::is_private(channel) && !(private_ok_mask & (1U<<i))) {
+            continue;
+        }
 
-            if (in_channel != routes[i].channel && !sent_to_chan[routes[i].channel]) {
-                
-                if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg.len) +
-                    GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        if (comm_get_txspace(channel) >= ((uint16_t)msg.len) +
+            GCS_MAVLINK::packet_overhead_chan(channel)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_channel,
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_channel,
+                     (unsigned)channel,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
+            _mavlink_resend_uart(channel, &msg);
         }
+        forwarded = true;
+    }
+    if (forwarded && target_route != -1) {
+        routes[target_route].fwd_count++;
     }
 
     if (!forwarded && match_system) {
@@ -186,24 +311,22 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
 */
 void MAVLink_routing::send_to_components(const mavlink_message_t &msg)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if ((routes[i].sysid == mavlink_system.sysid) && !sent_to_chan[routes[i].channel]) {
-            if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg.len) +
-                GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+    const uint8_t mask = system_channel_mask[mavlink_system.sysid];
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) >= ((uint16_t)msg.len) +
+            GCS_MAVLINK::packet_overhead_chan(channel)) {
 #if ROUTING_DEBUG
-                ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
-                         msg.msgid,
-                         (unsigned)routes[i].channel,
-                         (unsigned)routes[i].sysid,
-                         (unsigned)routes[i].compid);
+            ::printf("send msg %u on chan %u sysid=%u\n",
+                     msg.msgid,
+                     (unsigned)channel,
+                     (unsigned)mavlink_system.sysid);
 #endif
-                _mavlink_resend_uart(routes[i].channel, &msg);
-                sent_to_chan[routes[i].channel] = true;
-            }
+            _mavlink_resend_uart(channel, &msg);
         }
     }
 }
@@ -215,11 +338,12 @@ void MAVLink_routing::send_to_components(const mavlink_message_t &msg)
 bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel)
 {
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].mavtype == mavtype) {
+    for (uint16_t i=0; i<MAVLINK_ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid != 0 && routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
-            channel = routes[i].channel;
+            // the lowest channel it has been seen on
+            channel = (mavlink_channel_t)(MAVLINK_COMM_0 + __builtin_ctz(routes[i].channel_mask));
             return true;
         }
     }
@@ -233,29 +357,37 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
 */
 void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0 ||
         (msg.sysid == mavlink_system.sysid &&
          msg.compid == mavlink_system.compid)) {
         return;
     }
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+
+    expire_routes();
+
+    const uint8_t chan_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    const uint32_t now_ms = AP_HAL::millis();
+    int16_t i = find_route_index(msg.sysid, msg.compid);
+    if (i == -1) {
+        if (num_routes >= MAVLINK_MAX_ROUTES) {
+            // full, replace the route we heard from least recently
+            uint16_t oldest = 0;
+            for (uint16_t j=0; j<MAVLINK_ROUTE_TABLE_SIZE; j++) {
+                if (routes[j].sysid != 0 &&
+                    (routes[oldest].sysid == 0 ||
+                     now_ms - routes[j].last_seen_ms > now_ms - routes[oldest].last_seen_ms)) {
+                    oldest = j;
+                }
             }
-            break;
+            remove_route(oldest);
+            update_channel_masks();
+        }
+        i = route_hash(msg.sysid, msg.compid);
+        while (routes[i].sysid != 0) {
+            i = (i + 1) & (MAVLINK_ROUTE_TABLE_SIZE - 1);
         }
-    }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
         routes[i].sysid = msg.sysid;
         routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-        }
         num_routes++;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
@@ -264,6 +396,18 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
                  (unsigned)in_channel);
 #endif
     }
+
+    struct route &r = routes[i];
+    if (!(r.channel_mask & chan_bit)) {
+        r.channel_mask |= chan_bit;
+        system_channel_mask[r.sysid] |= chan_bit;
+        all_channel_mask |= chan_bit;
+    }
+    if (r.mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    r.last_seen_ms = now_ms;
+    r.rx_count++;
 }
 
 
@@ -284,10 +428,9 @@ void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavli
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
+    const struct route *r = find_route(msg.sysid, msg.compid);
+    if (r != nullptr) {
+        mask &= ~r->channel_mask;
     }
 
     if (mask == 0) {
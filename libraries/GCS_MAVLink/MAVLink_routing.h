@@ -6,9 +6,25 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
-#define MAVLINK_MAX_ROUTES 20
+/*
+  size of the routing hash table, a power of two. Routes are kept for
+  every sysid/compid seen, and there can be a lot of them once
+  companion computers, gimbals, ADSB receivers and several GCSs share
+  links
+ */
+#ifndef MAVLINK_ROUTE_TABLE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define MAVLINK_ROUTE_TABLE_SIZE 256
+#else
+#define MAVLINK_ROUTE_TABLE_SIZE 64
+#endif
+#endif
+
+// keep the table at most 3/4 full so probes stay short
+#define MAVLINK_MAX_ROUTES (MAVLINK_ROUTE_TABLE_SIZE*3/4)
+
+// forget routes we haven't heard from in this long
+#define MAVLINK_ROUTE_EXPIRY_MS 30000
 
 /*
   object to handle MAVLink packet routing
@@ -41,17 +57,51 @@ public:
      */
     bool find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel);
 
-private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
-    uint8_t num_routes;
+    /*
+      a learned route to a sysid/compid, and the channels it has been
+      seen on
+     */
     struct route {
-        uint8_t sysid;
+        uint8_t sysid;          // zero for an empty slot
         uint8_t compid;
-        mavlink_channel_t channel;
+        uint8_t channel_mask;
         uint8_t mavtype;
-    } routes[MAVLINK_MAX_ROUTES];
-    
+        uint32_t last_seen_ms;
+        uint32_t rx_count;      // packets received from it
+        uint32_t fwd_count;     // packets forwarded to it by target
+    };
+
+    // the route to a sysid/compid, or nullptr if none is known
+    const struct route *find_route(uint8_t sysid, uint8_t compid) const;
+
+    // number of routes currently known
+    uint16_t get_num_routes() const { return num_routes; }
+
+private:
+    // open addressed hash table of routes, with linear probing
+    uint16_t num_routes;
+    struct route routes[MAVLINK_ROUTE_TABLE_SIZE];
+
+    // union of the channels of all routes
+    uint8_t all_channel_mask;
+
+    // channels each sysid has been seen on, for messages targeted at
+    // all components of a system. Only the systems with a route have
+    // bits set
+    uint8_t system_channel_mask[256];
+
+    // last time we looked for expired routes
+    uint32_t last_expiry_check_ms;
+
+    static_assert(MAVLINK_COMM_NUM_BUFFERS <= 8, "channel masks are 8 bit");
+    static_assert((MAVLINK_ROUTE_TABLE_SIZE & (MAVLINK_ROUTE_TABLE_SIZE-1)) == 0, "route table size must be a power of 2");
+
+    static uint16_t route_hash(uint8_t sysid, uint8_t compid);
+    int16_t find_route_index(uint8_t sysid, uint8_t compid) const;
+    void remove_route(uint16_t i);
+    void expire_routes(void);
+    void update_channel_masks(void);
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
@@ -234,6 +234,24 @@ void Aircraft::adjust_frame_time(float new_rate)
 void Aircraft::sync_frame_time(void)
 {
     frame_counter++;
+    if (lockstep) {
+        // never sleep, just report the speedup we are getting
+        if (frame_counter >= 1000) {
+            frame_counter = 0;
+            const uint64_t now = get_wall_time_us();
+            if (speedup_report_wall_us == 0) {
+                speedup_report_wall_us = now;
+                speedup_report_sim_us = time_now_us;
+            } else if (now - speedup_report_wall_us >= 10000000UL) {
+                achieved_speedup = (time_now_us - speedup_report_sim_us) / float(now - speedup_report_wall_us);
+                ::printf("SITL lockstep: %.1f sim-seconds per wall-second\n",
+                         static_cast<double>(achieved_speedup));
+                speedup_report_wall_us = now;
+                speedup_report_sim_us = time_now_us;
+            }
+        }
+        return;
+    }
     uint64_t now = get_wall_time_us();
     if (frame_counter >= 40 &&
         now > last_wall_time_us) {
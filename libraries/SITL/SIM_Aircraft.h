@@ -48,6 +48,19 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      run the simulation in lockstep with the autopilot as fast as
+      the CPU allows, without pacing it against the wall clock
+     */
+    void set_lockstep(bool enable) {
+        lockstep = enable;
+    }
+
+    // simulated seconds per wall clock second over the last report period
+    float get_achieved_speedup(void) const {
+        return achieved_speedup;
+    }
+
     /*
       set instance number
      */
@@ -262,6 +275,11 @@ private:
     uint32_t last_ground_contact_ms;
     const uint32_t min_sleep_time;
 
+    bool lockstep = false;
+    float achieved_speedup = 0;
+    uint64_t speedup_report_wall_us = 0;
+    uint64_t speedup_report_sim_us = 0;
+
     struct {
         bool enabled;
         Vector3f accel_body;